@@ -3,15 +3,31 @@
 #include "ClimbingSystemCharacter.h"
 
 #include "Camera/CameraComponent.h"
+#include "ClimbingLimbIKComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "Components/InputComponent.h"
+#include "Engine/World.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/Controller.h"
 #include "GameFramework/SpringArmComponent.h"
 #include "EnhancedInputComponent.h"
 #include "EnhancedInputSubsystems.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/ScopeExit.h"
 #include "MyCharacterMovementComponent.h"
 
+namespace
+{
+	TAutoConsoleVariable<int32> CVarClimbAdaptiveReplication(
+		TEXT("climb.AdaptiveReplication"),
+		1,
+		TEXT("Whether climbing characters replicate as often as their climbing state needs, and are culled by line of sight from far viewers.\n")
+		TEXT("Turned off, they replicate like any other character, to compare bandwidth and server cost against it."),
+		ECVF_Default);
+}
+
+FClimbingNetRelevancyStats AClimbingSystemCharacter::NetRelevancyStats;
+
 //////////////////////////////////////////////////////////////////////////
 // AClimbingSystemCharacter
 
@@ -39,6 +55,9 @@ AClimbingSystemCharacter::AClimbingSystemCharacter(const FObjectInitializer& obj
 
 	MovementComponent = Cast<UMyCharacterMovementComponent>(GetCharacterMovement());
 
+	// Create the hands and feet placement used by the climbing animations
+	ClimbingLimbIK = CreateDefaultSubobject<UClimbingLimbIKComponent>(TEXT("ClimbingLimbIK"));
+
 	// Note: The skeletal mesh and anim blueprint references on the Mesh component (inherited from Character) 
 	// are set in the derived blueprint asset named ThirdPersonCharacter (to avoid direct content references in C++)
 }
@@ -53,11 +72,205 @@ UCameraComponent* AClimbingSystemCharacter::GetFollowCamera() const
 	return FollowCamera;
 }
 
+void AClimbingSystemCharacter::BeginPlay()
+{
+	Super::BeginPlay();
+
+	DefaultCameraArmLength = CameraBoom->TargetArmLength;
+	DefaultNetUpdateFrequency = NetUpdateFrequency;
+}
+
+void AClimbingSystemCharacter::Tick(float deltaSeconds)
+{
+	Super::Tick(deltaSeconds);
+
+	UpdateClimbingCamera(deltaSeconds);
+	UpdateClimbingNetUpdateFrequency();
+}
+
+bool AClimbingSystemCharacter::IsNetRelevantFor(const AActor* realViewer, const AActor* viewTarget, const FVector& srcLocation) const
+{
+	const uint64 startCycles = FPlatformTime::Cycles64();
+	ON_SCOPE_EXIT
+	{
+		++NetRelevancyStats.NumChecks;
+		NetRelevancyStats.Cycles += FPlatformTime::Cycles64() - startCycles;
+	};
+
+	if (Super::IsNetRelevantFor(realViewer, viewTarget, srcLocation) == false)
+	{
+		return false;
+	}
+
+	const bool isOnWall = MovementComponent->IsClimbing() || MovementComponent->IsShimmying();
+	const bool isViewedByOwner = IsOwnedBy(viewTarget) || IsOwnedBy(realViewer);
+
+	if (bAlwaysRelevant || isViewedByOwner || isOnWall == false || CVarClimbAdaptiveReplication.GetValueOnGameThread() == 0)
+	{
+		return true;
+	}
+
+	// Nearby climbers stay relevant, only the ones on far walls cost a visibility trace.
+	if (FVector::DistSquared(srcLocation, GetActorLocation()) <= FMath::Square(ClimbingLineOfSightDistance))
+	{
+		return true;
+	}
+
+	++NetRelevancyStats.NumLineOfSightTraces;
+
+	FCollisionQueryParams queryParams(SCENE_QUERY_STAT(ClimbingNetRelevancy), false, this);
+	queryParams.AddIgnoredActor(viewTarget);
+
+	return GetWorld()->LineTraceTestByChannel(srcLocation, GetActorLocation(), ECC_Visibility, queryParams) == false;
+}
+
+void AClimbingSystemCharacter::UpdateClimbingNetUpdateFrequency()
+{
+	if (GetLocalRole() != ROLE_Authority || IsNetMode(NM_Standalone))
+	{
+		return;
+	}
+
+	const float netUpdateFrequency = CVarClimbAdaptiveReplication.GetValueOnGameThread() != 0 ? GetClimbingNetUpdateFrequency() : DefaultNetUpdateFrequency;
+	if (netUpdateFrequency == NetUpdateFrequency)
+	{
+		return;
+	}
+
+	// Going faster, e.g. dashing from an idle hang, shouldn't wait for the slower tier's next update to be seen.
+	if (netUpdateFrequency > NetUpdateFrequency)
+	{
+		ForceNetUpdate();
+	}
+
+	NetUpdateFrequency = netUpdateFrequency;
+}
+
+float AClimbingSystemCharacter::GetClimbingNetUpdateFrequency() const
+{
+	if (MovementComponent->IsClimbing() == false && MovementComponent->IsShimmying() == false)
+	{
+		return DefaultNetUpdateFrequency;
+	}
+
+	switch (MovementComponent->GetClimbingState())
+	{
+	case EClimbingState::Idle:
+		return IdleClimbingNetUpdateFrequency;
+	case EClimbingState::Dashing:
+		return ClimbDashingNetUpdateFrequency;
+	case EClimbingState::ClimbingLedge:
+		return ClimbingLedgeNetUpdateFrequency;
+	default:
+		return ClimbingNetUpdateFrequency;
+	}
+}
+
+void AClimbingSystemCharacter::UpdateClimbingCamera(float deltaSeconds)
+{
+	if (IsLocallyControlled() == false)
+	{
+		return;
+	}
+
+	const bool isOnWall = MovementComponent->IsClimbing() || MovementComponent->IsShimmying();
+	const FVector surfaceNormal = MovementComponent->GetClimbSurfaceNormal();
+
+	if (isOnWall == false || surfaceNormal.IsZero())
+	{
+		if (CameraBoom->bDoCollisionTest == false)
+		{
+			CameraBoom->bDoCollisionTest = true;
+			CameraBoom->TargetArmLength = DefaultCameraArmLength;
+		}
+
+		// Probe right away once climbing starts.
+		FramesSinceClimbingCameraProbe = ClimbingCameraProbeInterval;
+		return;
+	}
+
+	// The climbed wall is what the arm would hit every frame, its plane is already known so the arm doesn't probe it.
+	// The rest of the surroundings is probed every few frames instead.
+	CameraBoom->bDoCollisionTest = false;
+
+	const FVector armOrigin = CameraBoom->GetComponentLocation();
+	const FVector armDirection = -CameraBoom->GetTargetRotation().Vector();
+	const float approachSpeed = -FVector::DotProduct(armDirection, surfaceNormal);
+
+	float desiredArmLength = DefaultCameraArmLength;
+	if (approachSpeed > KINDA_SMALL_NUMBER)
+	{
+		const float distanceToSurface = FVector::PointPlaneDist(armOrigin, MovementComponent->GetClimbSurfacePosition(), surfaceNormal);
+		desiredArmLength = FMath::Clamp((distanceToSurface - ClimbingCameraWallMargin) / approachSpeed, 0.f, DefaultCameraArmLength);
+	}
+
+	if (++FramesSinceClimbingCameraProbe >= ClimbingCameraProbeInterval)
+	{
+		FramesSinceClimbingCameraProbe = 0;
+		ClimbingCameraProbeArmLength = ProbeClimbingCameraArm(armOrigin, armDirection);
+	}
+
+	desiredArmLength = FMath::Min(desiredArmLength, ClimbingCameraProbeArmLength);
+
+	// Blocked by the floor, a side wall or an overhang: pull in right away rather than interpolating through it.
+	const float armLength = FMath::FInterpTo(CameraBoom->TargetArmLength, desiredArmLength, deltaSeconds, ClimbingCameraInterpSpeed);
+	CameraBoom->TargetArmLength = FMath::Min(armLength, ClimbingCameraProbeArmLength);
+}
+
+float AClimbingSystemCharacter::ProbeClimbingCameraArm(const FVector& armOrigin, const FVector& armDirection) const
+{
+	// Hits within about 18 degrees of the climbed wall's normal are that wall, which the arm is already clamped against.
+	constexpr float climbedPlaneMinDot = 0.95f;
+
+	const FCollisionQueryParams queryParams(SCENE_QUERY_STAT(ClimbingCameraProbe), false, this);
+
+	// Everything that would block is reported as a touch instead, in order, so the climbed plane can be skipped
+	// without skipping the floor or overhangs of the same landscape or merged mesh.
+	FCollisionResponseParams responseParams;
+	responseParams.CollisionResponse.SetAllChannels(ECR_Overlap);
+
+	TArray<FHitResult> hits;
+	const FVector armEnd = armOrigin + armDirection * DefaultCameraArmLength;
+	GetWorld()->SweepMultiByChannel(hits, armOrigin, armEnd, FQuat::Identity, CameraBoom->ProbeChannel,
+		FCollisionShape::MakeSphere(CameraBoom->ProbeSize), queryParams, responseParams);
+
+	const FVector climbedNormal = MovementComponent->GetClimbSurfaceNormal();
+
+	for (const FHitResult& hit : hits)
+	{
+		const UPrimitiveComponent* component = hit.GetComponent();
+		const bool isBlocking = component != nullptr && component->GetCollisionResponseToChannel(CameraBoom->ProbeChannel) == ECR_Block;
+		const bool isClimbedPlane = FVector::DotProduct(hit.ImpactNormal, climbedNormal) >= climbedPlaneMinDot;
+
+		if (isBlocking && isClimbedPlane == false)
+		{
+			return DefaultCameraArmLength * hit.Time;
+		}
+	}
+
+	return DefaultCameraArmLength;
+}
+
+UClimbingLimbIKComponent* AClimbingSystemCharacter::GetClimbingLimbIK() const
+{
+	return ClimbingLimbIK;
+}
+
 UMyCharacterMovementComponent* AClimbingSystemCharacter::GetMyCharacterMovement() const
 {
 	return MovementComponent;
 }
 
+const FClimbingNetRelevancyStats& AClimbingSystemCharacter::GetNetRelevancyStats()
+{
+	return NetRelevancyStats;
+}
+
+void AClimbingSystemCharacter::ResetNetRelevancyStats()
+{
+	NetRelevancyStats = FClimbingNetRelevancyStats();
+}
+
 //////////////////////////////////////////////////////////////////////////
 // Input
 
@@ -108,7 +321,7 @@ void AClimbingSystemCharacter::Jump()
 
 void AClimbingSystemCharacter::Climb()
 {
-	if (MovementComponent->IsClimbing())
+	if (MovementComponent->IsClimbing() || MovementComponent->IsShimmying())
 	{
 		MovementComponent->CancelClimbing();
 	}
@@ -136,7 +349,7 @@ void AClimbingSystemCharacter::Move(const FInputActionValue& value)
 		{
 			// get forward vector
 			FVector direction;
-			if (MovementComponent->IsClimbing())
+			if (MovementComponent->IsClimbing() || MovementComponent->IsShimmying())
 			{
 				direction = FVector::CrossProduct(MovementComponent->GetClimbSurfaceNormal(), -GetActorRightVector());
 			}
@@ -154,7 +367,7 @@ void AClimbingSystemCharacter::Move(const FInputActionValue& value)
 		{
 			// Get right vector
 			FVector direction;
-			if (MovementComponent->IsClimbing())
+			if (MovementComponent->IsClimbing() || MovementComponent->IsShimmying())
 			{
 				direction = FVector::CrossProduct(MovementComponent->GetClimbSurfaceNormal(), GetActorUpVector());
 			}
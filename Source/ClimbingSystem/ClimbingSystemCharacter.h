@@ -8,12 +8,24 @@
 #include "ClimbingSystemCharacter.generated.h"
 
 class UCameraComponent;
+class UClimbingLimbIKComponent;
 class UInputAction;
 class UInputComponent;
 class UInputMappingContext;
 class USpringArmComponent;
 class UMyCharacterMovementComponent;
 
+/** Cost of the climbing characters' net relevancy checks on the server, accumulated until reset by whoever reads them */
+struct FClimbingNetRelevancyStats
+{
+	int32 NumChecks = 0;
+
+	/** Checks that had to trace to a far viewer */
+	int32 NumLineOfSightTraces = 0;
+
+	uint64 Cycles = 0;
+};
+
 UCLASS(config=Game)
 class AClimbingSystemCharacter : public ACharacter
 {
@@ -28,35 +40,107 @@ public:
 	/** Start to climb or cancel it depending on its current state. */
 	virtual void Climb();
 
+	/** Called for movement input */
+	void Move(const FInputActionValue& value);
+
 	/** Returns CameraBoom subobject **/
 	FORCEINLINE USpringArmComponent* GetCameraBoom() const;
 
 	/** Returns FollowCamera subobject **/
 	FORCEINLINE UCameraComponent* GetFollowCamera() const;
 
+	/** Returns ClimbingLimbIK subobject **/
+	FORCEINLINE UClimbingLimbIKComponent* GetClimbingLimbIK() const;
+
 	/** Returns MovementComponent subobject **/
 	FORCEINLINE UMyCharacterMovementComponent* GetMyCharacterMovement() const;
 
+	static const FClimbingNetRelevancyStats& GetNetRelevancyStats();
+
+	static void ResetNetRelevancyStats();
+
 protected:
+	// AActor interface
+	virtual void BeginPlay() override;
+	virtual void Tick(float deltaSeconds) override;
+	virtual bool IsNetRelevantFor(const AActor* realViewer, const AActor* viewTarget, const FVector& srcLocation) const override;
+	// End of AActor interface
+
 	// APawn interface
 	virtual void SetupPlayerInputComponent(UInputComponent* playerInputComponent) override;
 	// End of APawn interface
 
 private:
-	/** Called for movement input */
-	void Move(const FInputActionValue& value);
-
 	/** Called for looking input */
 	void Look(const FInputActionValue& value);
 
+	/** Place the camera against the known climbing surface instead of probing it */
+	void UpdateClimbingCamera(float deltaSeconds);
+
+	/** Longest arm the camera can have without going through anything but the climbed wall's plane */
+	float ProbeClimbingCameraArm(const FVector& armOrigin, const FVector& armDirection) const;
+
+	/** Replicate as often as the climbing sub-state needs, on the server only */
+	void UpdateClimbingNetUpdateFrequency();
+
+	float GetClimbingNetUpdateFrequency() const;
+
 	/** Movement component handling the character's climbing mechanic */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Component, meta = (AllowPrivateAccess = "true"))
 		UMyCharacterMovementComponent* MovementComponent;
 
+	/** Places hands and feet on the climbing surface */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Component, meta = (AllowPrivateAccess = "true"))
+		TObjectPtr<UClimbingLimbIKComponent> ClimbingLimbIK;
+
 	/** Camera boom positioning the camera behind the character */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
 		TObjectPtr<USpringArmComponent> CameraBoom;
 
+	/** Distance kept between the camera and the climbed surface */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true", ClampMin = "0.0"))
+		float ClimbingCameraWallMargin = 20.f;
+
+	/** Speed at which the arm length follows the climbed surface */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true", ClampMin = "0.0"))
+		float ClimbingCameraInterpSpeed = 8.f;
+
+	/** Frames between two probes of the floor, side walls and overhangs around the camera while climbing */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true", ClampMin = "1"))
+		int32 ClimbingCameraProbeInterval = 4;
+
+	/** Arm length restored once the character stops climbing */
+	float DefaultCameraArmLength = 0.f;
+
+	int32 FramesSinceClimbingCameraProbe = 0;
+
+	float ClimbingCameraProbeArmLength = 0.f;
+
+	/** Net update frequency while hanging still on a wall */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Replication, meta = (AllowPrivateAccess = "true", ClampMin = "1.0"))
+		float IdleClimbingNetUpdateFrequency = 5.f;
+
+	/** Net update frequency while climbing or shimmying along a wall */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Replication, meta = (AllowPrivateAccess = "true", ClampMin = "1.0"))
+		float ClimbingNetUpdateFrequency = 30.f;
+
+	/** Net update frequency while dashing on a wall */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Replication, meta = (AllowPrivateAccess = "true", ClampMin = "1.0"))
+		float ClimbDashingNetUpdateFrequency = 60.f;
+
+	/** Net update frequency while climbing up a ledge, the montage drives the character in between */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Replication, meta = (AllowPrivateAccess = "true", ClampMin = "1.0"))
+		float ClimbingLedgeNetUpdateFrequency = 15.f;
+
+	/** Beyond this distance, a climbing character is only relevant to the viewers that can see it */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Replication, meta = (AllowPrivateAccess = "true", ClampMin = "0.0"))
+		float ClimbingLineOfSightDistance = 3000.f;
+
+	/** Net update frequency restored once the character stops climbing */
+	float DefaultNetUpdateFrequency = 0.f;
+
+	static FClimbingNetRelevancyStats NetRelevancyStats;
+
 	/** Follow camera */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
 		TObjectPtr<UCameraComponent> FollowCamera;
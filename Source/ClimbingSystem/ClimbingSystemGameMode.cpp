@@ -2,8 +2,19 @@
 
 #include "ClimbingSystemGameMode.h"
 #include "ClimbingSystemCharacter.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "MyCharacterMovementComponent.h"
 #include "UObject/ConstructorHelpers.h"
 
+DEFINE_LOG_CATEGORY_STATIC(LogClimbingNetStats, Log, All);
+
 AClimbingSystemGameMode::AClimbingSystemGameMode()
 {
 	// set default pawn class to our Blueprinted character
@@ -12,4 +23,155 @@ AClimbingSystemGameMode::AClimbingSystemGameMode()
 	{
 		DefaultPawnClass = PlayerPawnBPClass.Class;
 	}
+
+	// Only ticks to record the net stats.
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
+}
+
+void AClimbingSystemGameMode::BeginPlay()
+{
+	Super::BeginPlay();
+
+	const bool isServer = GetNetMode() == NM_DedicatedServer || GetNetMode() == NM_ListenServer;
+	bRecordNetStats = isServer && FParse::Param(FCommandLine::Get(), TEXT("ClimbingNetStats"));
+
+	if (bRecordNetStats)
+	{
+		FParse::Value(FCommandLine::Get(), TEXT("ClimbingNetStatsDuration="), NetStatsDuration);
+
+		AClimbingSystemCharacter::ResetNetRelevancyStats();
+		SetActorTickEnabled(true);
+	}
+}
+
+void AClimbingSystemGameMode::EndPlay(const EEndPlayReason::Type endPlayReason)
+{
+	if (bRecordNetStats)
+	{
+		WriteNetStats();
+	}
+
+	Super::EndPlay(endPlayReason);
+}
+
+void AClimbingSystemGameMode::Tick(float deltaSeconds)
+{
+	Super::Tick(deltaSeconds);
+
+	if (bRecordNetStats == false)
+	{
+		return;
+	}
+
+	// A dedicated server sleeps between frames to hold its tick rate, that time isn't spent on the game.
+	NetStatsBusySeconds += FMath::Max(FApp::GetDeltaTime() - FApp::GetIdleTime(), 0.);
+	++NumNetStatsFrames;
+
+	NetStatsTime += deltaSeconds;
+	TimeSinceNetStatsSample += deltaSeconds;
+
+	// Connections update their bandwidth once a second.
+	if (TimeSinceNetStatsSample >= 1.f)
+	{
+		SampleNetStats();
+		TimeSinceNetStatsSample = 0.f;
+	}
+
+	if (NetStatsDuration > 0.f && NetStatsTime >= NetStatsDuration)
+	{
+		WriteNetStats();
+		FPlatformMisc::RequestExit(false);
+	}
+}
+
+void AClimbingSystemGameMode::SampleNetStats()
+{
+	FNetStatsSample& sample = NetStatsSamples.AddDefaulted_GetRef();
+	sample.Time = NetStatsTime;
+
+	int64 outBytesPerSecond = 0;
+
+	if (const UNetDriver* netDriver = GetWorld()->GetNetDriver())
+	{
+		for (const UNetConnection* connection : netDriver->ClientConnections)
+		{
+			if (connection != nullptr)
+			{
+				outBytesPerSecond += connection->OutBytesPerSecond;
+				sample.MaxOutBytesPerSecond = FMath::Max(sample.MaxOutBytesPerSecond, connection->OutBytesPerSecond);
+				++sample.NumConnections;
+			}
+		}
+	}
+
+	for (TActorIterator<AClimbingSystemCharacter> characterIt(GetWorld()); characterIt; ++characterIt)
+	{
+		const UMyCharacterMovementComponent* movement = characterIt->GetMyCharacterMovement();
+		sample.NumClimbers += movement->IsClimbing() || movement->IsShimmying() ? 1 : 0;
+	}
+
+	const FClimbingNetRelevancyStats& relevancyStats = AClimbingSystemCharacter::GetNetRelevancyStats();
+	const float numFrames = FMath::Max(NumNetStatsFrames, 1);
+
+	sample.AverageOutBytesPerSecond = sample.NumConnections > 0 ? (float)outBytesPerSecond / sample.NumConnections : 0.f;
+	sample.BusyMillisecondsPerFrame = NetStatsBusySeconds * 1000. / numFrames;
+	sample.RelevancyMillisecondsPerFrame = FPlatformTime::ToMilliseconds64(relevancyStats.Cycles) / numFrames;
+	sample.RelevancyChecksPerFrame = relevancyStats.NumChecks / numFrames;
+	sample.LineOfSightTracesPerFrame = relevancyStats.NumLineOfSightTraces / numFrames;
+
+	AClimbingSystemCharacter::ResetNetRelevancyStats();
+	NetStatsBusySeconds = 0.;
+	NumNetStatsFrames = 0;
+}
+
+void AClimbingSystemGameMode::WriteNetStats()
+{
+	bRecordNetStats = false;
+	SetActorTickEnabled(false);
+
+	const IConsoleVariable* adaptiveReplication = IConsoleManager::Get().FindConsoleVariable(TEXT("climb.AdaptiveReplication"));
+	const bool isAdaptive = adaptiveReplication != nullptr && adaptiveReplication->GetInt() != 0;
+
+	const FString filePath = FPaths::ProjectSavedDir() / TEXT("Profiling") / TEXT("ClimbingNetStats") /
+		FString::Printf(TEXT("ClimbingNetStats-%s-%s.csv"), isAdaptive ? TEXT("Adaptive") : TEXT("Default"), *FDateTime::Now().ToString());
+
+	FString csv = TEXT("Time,NumConnections,NumClimbers,AverageOutBytesPerSecond,MaxOutBytesPerSecond,BusyMillisecondsPerFrame,RelevancyMillisecondsPerFrame,RelevancyChecksPerFrame,LineOfSightTracesPerFrame\n");
+
+	FNetStatsSample average;
+	int32 numSamples = 0;
+
+	for (const FNetStatsSample& sample : NetStatsSamples)
+	{
+		csv += FString::Printf(TEXT("%.1f,%d,%d,%.1f,%d,%.4f,%.4f,%.2f,%.2f\n"), sample.Time, sample.NumConnections, sample.NumClimbers,
+			sample.AverageOutBytesPerSecond, sample.MaxOutBytesPerSecond, sample.BusyMillisecondsPerFrame,
+			sample.RelevancyMillisecondsPerFrame, sample.RelevancyChecksPerFrame, sample.LineOfSightTracesPerFrame);
+
+		// The averages leave out the time clients were still joining.
+		if (sample.NumConnections > 0)
+		{
+			average.AverageOutBytesPerSecond += sample.AverageOutBytesPerSecond;
+			average.BusyMillisecondsPerFrame += sample.BusyMillisecondsPerFrame;
+			average.RelevancyMillisecondsPerFrame += sample.RelevancyMillisecondsPerFrame;
+			average.NumClimbers += sample.NumClimbers;
+			average.NumConnections = FMath::Max(average.NumConnections, sample.NumConnections);
+			++numSamples;
+		}
+	}
+
+	if (FFileHelper::SaveStringToFile(csv, *filePath) == false)
+	{
+		UE_LOG(LogClimbingNetStats, Error, TEXT("Could not write %s"), *filePath);
+	}
+	else
+	{
+		UE_LOG(LogClimbingNetStats, Display, TEXT("Wrote %s"), *filePath);
+	}
+
+	if (numSamples > 0)
+	{
+		UE_LOG(LogClimbingNetStats, Display, TEXT("%s replication, up to %d connections, %.1f climbing on average: %.0f bytes/s per connection, %.3f ms busy per frame, %.4f ms of it in net relevancy"),
+			isAdaptive ? TEXT("Adaptive") : TEXT("Default"), average.NumConnections, (float)average.NumClimbers / numSamples,
+			average.AverageOutBytesPerSecond / numSamples, average.BusyMillisecondsPerFrame / numSamples, average.RelevancyMillisecondsPerFrame / numSamples);
+	}
 }
@@ -6,6 +6,16 @@
 #include "GameFramework/GameModeBase.h"
 #include "ClimbingSystemGameMode.generated.h"
 
+/**
+ * With -ClimbingNetStats on a server, records every second what each client connection is sent and how busy the server is,
+ * and writes it to Saved/Profiling/ClimbingNetStats once -ClimbingNetStatsDuration seconds have passed or the server stops.
+ *
+ * Usage, once with climb.AdaptiveReplication 0 and once with 1 to compare them:
+ *   Server:  UnrealEditor ClimbingSystem.uproject /Game/ClimbingSystem/Maps/TestClimbingLevel -server -nullrhi -log -ClimbingNetStats
+ *            [-ClimbingNetStatsDuration=120] [-ExecCmds="climb.AdaptiveReplication 0"]
+ *   Clients: UnrealEditor ClimbingSystem.uproject 127.0.0.1 -game -nullrhi -nosound -ClimbingBot
+ * Tests/ClimbingNet/MeasureClimbingNet.sh runs both with a number of bots, see UClimbingBotSubsystem.
+ */
 UCLASS(minimalapi)
 class AClimbingSystemGameMode : public AGameModeBase
 {
@@ -13,6 +23,48 @@ class AClimbingSystemGameMode : public AGameModeBase
 
 public:
 	AClimbingSystemGameMode();
+
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type endPlayReason) override;
+
+	virtual void Tick(float deltaSeconds) override;
+
+private:
+	struct FNetStatsSample
+	{
+		float Time = 0.f;
+		int32 NumConnections = 0;
+		int32 NumClimbers = 0;
+		float AverageOutBytesPerSecond = 0.f;
+		int32 MaxOutBytesPerSecond = 0;
+
+		/** Game thread time not spent waiting for the next frame */
+		float BusyMillisecondsPerFrame = 0.f;
+
+		float RelevancyMillisecondsPerFrame = 0.f;
+		float RelevancyChecksPerFrame = 0.f;
+		float LineOfSightTracesPerFrame = 0.f;
+	};
+
+	void SampleNetStats();
+
+	void WriteNetStats();
+
+	bool bRecordNetStats = false;
+
+	/** 0 records until the server stops */
+	float NetStatsDuration = 0.f;
+
+	float NetStatsTime = 0.f;
+
+	float TimeSinceNetStatsSample = 0.f;
+
+	double NetStatsBusySeconds = 0.;
+
+	int32 NumNetStatsFrames = 0;
+
+	TArray<FNetStatsSample> NetStatsSamples;
 };
 
 
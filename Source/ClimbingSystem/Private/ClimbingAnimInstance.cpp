@@ -0,0 +1,59 @@
+#include "ClimbingAnimInstance.h"
+
+#include "MyCharacterMovementComponent.h"
+#include "GameFramework/Pawn.h"
+
+void FClimbingAnimInstanceProxy::PreUpdate(UAnimInstance* animInstance, float deltaSeconds)
+{
+	Super::PreUpdate(animInstance, deltaSeconds);
+
+	// Game thread: the only place the movement component is read from.
+	const APawn* pawn = animInstance->TryGetPawnOwner();
+	const UMyCharacterMovementComponent* movement = pawn ? Cast<UMyCharacterMovementComponent>(pawn->GetMovementComponent()) : nullptr;
+
+	if (movement == nullptr)
+	{
+		return;
+	}
+
+	bIsClimbing = movement->IsClimbing();
+	bIsShimmying = movement->IsShimmying();
+	bIsClimbDashing = movement->IsClimbDashing();
+	bIsClimbingLedge = movement->IsClimbingLedge();
+	bIsFalling = movement->IsFalling();
+	ClimbSurfaceNormal = movement->GetClimbSurfaceNormal();
+	ClimbingDirection = movement->GetClimbingDirection();
+	Velocity = movement->Velocity;
+
+	if (const UClimbingLimbIKComponent* limbIK = pawn->FindComponentByClass<UClimbingLimbIKComponent>())
+	{
+		HandLeftPlacement = limbIK->GetLimbPlacement(EClimbingLimb::HandLeft);
+		HandRightPlacement = limbIK->GetLimbPlacement(EClimbingLimb::HandRight);
+		FootLeftPlacement = limbIK->GetLimbPlacement(EClimbingLimb::FootLeft);
+		FootRightPlacement = limbIK->GetLimbPlacement(EClimbingLimb::FootRight);
+	}
+}
+
+void FClimbingAnimInstanceProxy::Update(float deltaSeconds)
+{
+	Super::Update(deltaSeconds);
+
+	// Worker thread: only the snapshot taken in PreUpdate is used from here.
+	GroundSpeed = Velocity.Size2D();
+
+	const FVector surfaceRight = FVector::CrossProduct(ClimbSurfaceNormal, FVector::UpVector).GetSafeNormal();
+	const FVector surfaceUp = FVector::CrossProduct(surfaceRight, ClimbSurfaceNormal);
+
+	ClimbingRightSpeed = FVector::DotProduct(Velocity, surfaceRight);
+	ClimbingUpSpeed = FVector::DotProduct(Velocity, surfaceUp);
+}
+
+FAnimInstanceProxy* UClimbingAnimInstance::CreateAnimInstanceProxy()
+{
+	return &Proxy;
+}
+
+void UClimbingAnimInstance::DestroyAnimInstanceProxy(FAnimInstanceProxy* animInstanceProxy)
+{
+	// The proxy is a member of this instance, nothing to free.
+}
@@ -0,0 +1,96 @@
+#include "ClimbingBotSubsystem.h"
+
+#include "ClimbingSystemCharacter.h"
+#include "MyCharacterMovementComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Misc/CommandLine.h"
+
+bool UClimbingBotSubsystem::ShouldCreateSubsystem(UObject* outer) const
+{
+#if UE_BUILD_SHIPPING
+	return false;
+#else
+	return FParse::Param(FCommandLine::Get(), TEXT("ClimbingBot")) && Super::ShouldCreateSubsystem(outer);
+#endif
+}
+
+void UClimbingBotSubsystem::Initialize(FSubsystemCollectionBase& collection)
+{
+	Super::Initialize(collection);
+
+	Random.GenerateNewSeed();
+}
+
+ETickableTickType UClimbingBotSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+bool UClimbingBotSubsystem::IsTickable() const
+{
+	return GetBotCharacter() != nullptr;
+}
+
+TStatId UClimbingBotSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UClimbingBotSubsystem, STATGROUP_Tickables);
+}
+
+AClimbingSystemCharacter* UClimbingBotSubsystem::GetBotCharacter() const
+{
+	const UWorld* world = GetWorld();
+	if (world == nullptr || world->IsGameWorld() == false)
+	{
+		return nullptr;
+	}
+
+	const APlayerController* playerController = world->GetFirstPlayerController();
+	return playerController != nullptr ? Cast<AClimbingSystemCharacter>(playerController->GetPawn()) : nullptr;
+}
+
+void UClimbingBotSubsystem::Tick(float deltaTime)
+{
+	AClimbingSystemCharacter* character = GetBotCharacter();
+	if (character == nullptr)
+	{
+		return;
+	}
+
+	const UMyCharacterMovementComponent* movement = character->GetMyCharacterMovement();
+	const bool isOnWall = movement->IsClimbing() || movement->IsShimmying();
+
+	TimeToNextAction -= deltaTime;
+	if (TimeToNextAction <= 0.f)
+	{
+		TimeToNextAction = Random.FRandRange(0.5f, 4.f);
+		bHasLetGo = false;
+
+		// Hang still now and then, every climbing state gets its share of time.
+		MoveValue = Random.FRand() < 0.2f ? FVector2D::ZeroVector : FVector2D(Random.FRandRange(-1.f, 1.f), Random.FRandRange(-1.f, 1.f));
+
+		const float action = Random.FRand();
+
+		if (isOnWall && action < 0.2f)
+		{
+			character->Jump();
+		}
+		else if (isOnWall && action < 0.3f)
+		{
+			character->Climb();
+			bHasLetGo = true;
+		}
+		else if (isOnWall == false)
+		{
+			character->AddControllerYawInput(Random.FRandRange(-90.f, 90.f));
+		}
+	}
+
+	// Grabs the first wall it walks into.
+	if (isOnWall == false && bHasLetGo == false)
+	{
+		character->Climb();
+	}
+
+	character->Move(FInputActionValue(MoveValue));
+}
@@ -0,0 +1,524 @@
+#include "ClimbingCostCommandlet.h"
+
+#include "ClimbingSystemCharacter.h"
+#include "EngineUtils.h"
+#include "IImageWrapper.h"
+#include "IImageWrapperModule.h"
+#include "MyCharacterMovementComponent.h"
+#include "Engine/Engine.h"
+#include "GameFramework/WorldSettings.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Modules/ModuleManager.h"
+#include "Tickable.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogClimbingCost, Log, All);
+
+UClimbingCostCommandlet::UClimbingCostCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = true;
+	LogToConsole = true;
+}
+
+int32 UClimbingCostCommandlet::Main(const FString& params)
+{
+	FString mapName = TEXT("/Game/ClimbingSystem/Maps/TestClimbingLevel");
+	FString characterClassPath = TEXT("/Game/ClimbingSystem/Blueprints/BP_ThirdPersonCharacter.BP_ThirdPersonCharacter_C");
+	const FString outputDirectory = FPaths::ProjectSavedDir() / TEXT("Profiling") / TEXT("ClimbingCost");
+
+	FParse::Value(*params, TEXT("Map="), mapName);
+	FParse::Value(*params, TEXT("CharacterClass="), characterClassPath);
+	FParse::Value(*params, TEXT("GridSpacing="), GridSpacing);
+	FParse::Value(*params, TEXT("ProbeDuration="), ProbeDuration);
+	FParse::Value(*params, TEXT("MaxProbes="), MaxProbes);
+
+	// The probe grid steps by this spacing, it would never end otherwise.
+	if (GridSpacing <= 0.f)
+	{
+		UE_LOG(LogClimbingCost, Error, TEXT("-GridSpacing must be greater than 0, got %.2f"), GridSpacing);
+		return 1;
+	}
+
+	bVerifyRollback = FParse::Param(*params, TEXT("VerifyRollback"));
+	bCompareFixedStep = FParse::Param(*params, TEXT("CompareFixedStep"));
+
+	float frameRate = 1.f / FrameDeltaTime;
+	if (FParse::Value(*params, TEXT("FrameRate="), frameRate) && frameRate > 0.f)
+	{
+		FrameDeltaTime = 1.f / frameRate;
+	}
+
+	UWorld* world = LoadWorld(mapName);
+	if (world == nullptr)
+	{
+		UE_LOG(LogClimbingCost, Error, TEXT("Could not load map %s"), *mapName);
+		return 1;
+	}
+
+	TSubclassOf<ACharacter> characterClass = LoadClass<ACharacter>(nullptr, *characterClassPath);
+	if (characterClass == nullptr)
+	{
+		UE_LOG(LogClimbingCost, Warning, TEXT("Could not load %s, probing with the native character (no animations)"), *characterClassPath);
+		characterClass = AClimbingSystemCharacter::StaticClass();
+	}
+
+	const TArray<FProbeStart> starts = FindProbeStarts(world);
+	UE_LOG(LogClimbingCost, Display, TEXT("Probing %d climbing start points in %s"), starts.Num(), *mapName);
+
+	FActorSpawnParameters spawnParameters;
+	spawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	ACharacter* character = world->SpawnActor<ACharacter>(characterClass, FTransform::Identity, spawnParameters);
+	UMyCharacterMovementComponent* movement = character ? Cast<UMyCharacterMovementComponent>(character->GetCharacterMovement()) : nullptr;
+
+	if (movement == nullptr)
+	{
+		UE_LOG(LogClimbingCost, Error, TEXT("%s doesn't use the climbing movement component"), *characterClass->GetName());
+		return 1;
+	}
+
+	// The probe moves on its own, without any controller possessing it.
+	movement->bRunPhysicsWithNoController = true;
+
+	TArray<FProbeResult> results;
+	results.Reserve(starts.Num());
+
+	for (const FProbeStart& start : starts)
+	{
+		results.Add(RunProbe(world, character, start));
+	}
+
+	const int32 numDivergedProbes = results.FilterByPredicate([](const FProbeResult& result) { return result.RollbackDivergence > 0.f; }).Num();
+	if (numDivergedProbes > 0)
+	{
+		UE_LOG(LogClimbingCost, Error, TEXT("%d probes didn't replay the same trajectory from their climbing snapshot"), numDivergedProbes);
+	}
+
+	if (bCompareFixedStep)
+	{
+		float frameRateMilliseconds = 0.f;
+		float fixedStepMilliseconds = 0.f;
+		float maxDivergence = 0.f;
+		int32 numCompared = 0;
+
+		for (const FProbeResult& result : results)
+		{
+			if (result.FixedStepDivergence >= 0.f)
+			{
+				frameRateMilliseconds += result.FrameRateMillisecondsPerFrame;
+				fixedStepMilliseconds += result.FixedStepMillisecondsPerFrame;
+				maxDivergence = FMath::Max(maxDivergence, result.FixedStepDivergence);
+				++numCompared;
+			}
+		}
+
+		if (numCompared > 0)
+		{
+			UE_LOG(LogClimbingCost, Display, TEXT("At %.0f fps over %d probes: %.4f ms/frame per frame, %.4f ms/frame with fixed steps, %.2f apart at most"),
+				1.f / FrameDeltaTime, numCompared, frameRateMilliseconds / numCompared, fixedStepMilliseconds / numCompared, maxDivergence);
+		}
+	}
+
+	const bool wroteCsv = WriteCsv(outputDirectory / TEXT("ClimbingCost.csv"), results);
+	const bool wroteHeatmap = WriteHeatmap(outputDirectory / TEXT("ClimbingCost.png"), results);
+
+	results.Sort([](const FProbeResult& a, const FProbeResult& b) { return a.QueriesPerFrame > b.QueriesPerFrame; });
+	for (int32 resultIndex = 0; resultIndex < FMath::Min(10, results.Num()) && results[resultIndex].bStartedClimbing; ++resultIndex)
+	{
+		const FProbeResult& result = results[resultIndex];
+		UE_LOG(LogClimbingCost, Display, TEXT("%s: %.1f queries/frame, %.1f hits/sweep, %.3f ms/tick, %.2f deg jitter"),
+			*result.Start.Location.ToString(), result.QueriesPerFrame, result.HitsPerSweep, result.MillisecondsPerTick, result.AverageNormalJitter);
+	}
+
+	GEngine->DestroyWorldContext(world);
+	world->DestroyWorld(false);
+	world->RemoveFromRoot();
+
+	return wroteCsv && wroteHeatmap && numDivergedProbes == 0 ? 0 : 1;
+}
+
+UWorld* UClimbingCostCommandlet::LoadWorld(const FString& mapName) const
+{
+	UPackage* package = LoadPackage(nullptr, *mapName, LOAD_None);
+	UWorld* world = package ? UWorld::FindWorldInPackage(package) : nullptr;
+
+	if (world == nullptr)
+	{
+		return nullptr;
+	}
+
+	world->WorldType = EWorldType::Game;
+	world->AddToRoot();
+
+	FWorldContext& worldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	worldContext.SetCurrentWorld(world);
+	GWorld = world;
+
+	if (world->bIsWorldInitialized == false)
+	{
+		world->InitWorld(UWorld::InitializationValues()
+			.AllowAudioPlayback(false)
+			.CreatePhysicsScene(true)
+			.ShouldSimulatePhysics(true));
+	}
+
+	world->UpdateWorldComponents(true, false);
+
+	// There is no game mode to start play here, begin it directly.
+	const FURL url;
+	world->InitializeActorsForPlay(url);
+	world->GetWorldSettings()->NotifyBeginPlay();
+
+	return world;
+}
+
+TArray<UClimbingCostCommandlet::FProbeStart> UClimbingCostCommandlet::FindProbeStarts(UWorld* world) const
+{
+	TArray<FProbeStart> starts;
+
+	const float walkableFloorZ = GetDefault<UMyCharacterMovementComponent>()->GetWalkableFloorZ();
+	const FCollisionQueryParams queryParams(SCENE_QUERY_STAT(ClimbingCostProbe), false);
+	const FVector sides[] = { FVector::ForwardVector, FVector::BackwardVector, FVector::RightVector, FVector::LeftVector };
+
+	for (TActorIterator<AActor> actorIt(world); actorIt; ++actorIt)
+	{
+		TInlineComponentArray<UPrimitiveComponent*> primitives(*actorIt);
+
+		for (UPrimitiveComponent* primitive : primitives)
+		{
+			if (primitive->IsCollisionEnabled() == false || primitive->GetCollisionResponseToChannel(ECC_WorldStatic) != ECR_Block)
+			{
+				continue;
+			}
+
+			const FBox bounds = primitive->Bounds.GetBox();
+			const FVector center = bounds.GetCenter();
+			const FVector extent = bounds.GetExtent();
+
+			// Trace a grid on each side of the bounds towards its center, against this primitive only.
+			for (const FVector& side : sides)
+			{
+				const FVector tangent = FVector::CrossProduct(FVector::UpVector, side);
+				const float tangentExtent = FMath::Abs(FVector::DotProduct(extent, tangent));
+				const float sideExtent = FMath::Abs(FVector::DotProduct(extent, side));
+
+				for (float across = -tangentExtent; across <= tangentExtent; across += GridSpacing)
+				{
+					for (float height = -extent.Z; height <= extent.Z; height += GridSpacing)
+					{
+						const FVector end = center + tangent * across + FVector::UpVector * height;
+						const FVector start = end + side * (sideExtent + ProbeStandOff);
+
+						FHitResult hit;
+						if (primitive->LineTraceComponent(hit, start, end, queryParams) == false)
+						{
+							continue;
+						}
+
+						// Floors are walked on and ceilings can't be climbed.
+						const bool isClimbable = hit.ImpactNormal.Z < walkableFloorZ && hit.ImpactNormal.GetSafeNormal2D().IsZero() == false;
+						if (isClimbable == false)
+						{
+							continue;
+						}
+
+						starts.Add({ hit.ImpactPoint + hit.ImpactNormal * ProbeStandOff, hit.ImpactNormal });
+
+						if (starts.Num() >= MaxProbes)
+						{
+							UE_LOG(LogClimbingCost, Warning, TEXT("Reached %d probes, increase -GridSpacing or -MaxProbes to cover the whole map"), MaxProbes);
+							return starts;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	return starts;
+}
+
+UClimbingCostCommandlet::FProbeResult UClimbingCostCommandlet::RunProbe(UWorld* world, ACharacter* character, const FProbeStart& start) const
+{
+	FProbeResult result;
+	result.Start = start;
+
+	UMyCharacterMovementComponent* movement = Cast<UMyCharacterMovementComponent>(character->GetCharacterMovement());
+
+	// Leave the previous wall before moving the probe.
+	movement->CancelClimbing(true);
+	TickWorld(world);
+
+	character->TeleportTo(start.Location, (-start.Normal.GetSafeNormal2D()).Rotation(), false, true);
+	movement->StopMovementImmediately();
+
+	// The wall is swept on the first tick, the mode switches on the movement update following the climb request.
+	TickWorld(world);
+	movement->TryClimbing();
+	TickWorld(world);
+
+	if (movement->IsClimbing() == false)
+	{
+		return result;
+	}
+
+	result.bStartedClimbing = true;
+
+	const int32 numFrames = FMath::CeilToInt(ProbeDuration / FrameDeltaTime);
+
+	if (bVerifyRollback)
+	{
+		result.RollbackDivergence = MeasureRollbackDivergence(world, character, numFrames);
+	}
+
+	if (bCompareFixedStep)
+	{
+		CompareFixedClimbingStep(world, character, numFrames, result);
+	}
+
+	movement->ResetClimbingQueryStats();
+	int32 numFramesClimbed = 0;
+	int32 numJitterSamples = 0;
+	FVector previousNormal = movement->GetClimbSurfaceNormal();
+
+	for (; numFramesClimbed < numFrames && (movement->IsClimbing() || movement->IsShimmying()); ++numFramesClimbed)
+	{
+		ApplyProbeInput(character, numFramesClimbed, numFrames);
+		TickWorld(world);
+
+		const FVector normal = movement->GetClimbSurfaceNormal();
+		if (previousNormal.IsZero() == false && normal.IsZero() == false)
+		{
+			const float jitter = FMath::RadiansToDegrees(FMath::Acos(FMath::Clamp(FVector::DotProduct(previousNormal, normal), -1.f, 1.f)));
+
+			result.AverageNormalJitter += jitter;
+			result.MaxNormalJitter = FMath::Max(result.MaxNormalJitter, jitter);
+			++numJitterSamples;
+		}
+
+		previousNormal = normal;
+	}
+
+	const FClimbingQueryStats& stats = movement->GetClimbingQueryStats();
+
+	result.QueriesPerFrame = numFramesClimbed > 0 ? (float)stats.NumQueries / numFramesClimbed : 0.f;
+	result.HitsPerSweep = stats.NumWallSweeps > 0 ? (float)stats.NumWallHits / stats.NumWallSweeps : 0.f;
+	result.MillisecondsPerTick = stats.NumPhysTicks > 0 ? FPlatformTime::ToMilliseconds64(stats.PhysCycles) / stats.NumPhysTicks : 0.f;
+	result.AverageNormalJitter = numJitterSamples > 0 ? result.AverageNormalJitter / numJitterSamples : 0.f;
+
+	return result;
+}
+
+void UClimbingCostCommandlet::ApplyProbeInput(ACharacter* character, int32 frame, int32 numFrames) const
+{
+	const UMyCharacterMovementComponent* movement = Cast<UMyCharacterMovementComponent>(character->GetCharacterMovement());
+	const FVector normal = movement->GetClimbSurfaceNormal();
+
+	// Circle around on the wall so the probe covers the surroundings of its start point.
+	const FVector right = FVector::CrossProduct(normal, FVector::UpVector).GetSafeNormal();
+	const FVector up = FVector::CrossProduct(right, normal);
+	const float angle = 2.f * PI * frame / numFrames;
+
+	character->AddMovementInput(right * FMath::Cos(angle) + up * FMath::Sin(angle));
+}
+
+float UClimbingCostCommandlet::MeasureRollbackDivergence(UWorld* world, ACharacter* character, int32 numFrames) const
+{
+	UMyCharacterMovementComponent* movement = Cast<UMyCharacterMovementComponent>(character->GetCharacterMovement());
+
+	FClimbingStateSnapshot snapshot;
+	movement->SaveClimbingState(snapshot);
+
+	TArray<FVector> trajectory;
+	trajectory.Reserve(numFrames);
+
+	for (int32 frame = 0; frame < numFrames; ++frame)
+	{
+		ApplyProbeInput(character, frame, numFrames);
+		TickWorld(world);
+
+		trajectory.Add(character->GetActorLocation());
+	}
+
+	movement->RestoreClimbingState(snapshot);
+
+	float maxDivergence = 0.f;
+	for (int32 frame = 0; frame < numFrames; ++frame)
+	{
+		ApplyProbeInput(character, frame, numFrames);
+		TickWorld(world);
+
+		maxDivergence = FMath::Max(maxDivergence, FVector::Dist(trajectory[frame], character->GetActorLocation()));
+	}
+
+	// Start the cost measurement from the same state as without the check.
+	movement->RestoreClimbingState(snapshot);
+
+	return maxDivergence;
+}
+
+void UClimbingCostCommandlet::CompareFixedClimbingStep(UWorld* world, ACharacter* character, int32 numFrames, FProbeResult& result) const
+{
+	UMyCharacterMovementComponent* movement = Cast<UMyCharacterMovementComponent>(character->GetCharacterMovement());
+	const bool wasUsingFixedClimbingStep = movement->IsUsingFixedClimbingStep();
+
+	FClimbingStateSnapshot snapshot;
+	movement->SaveClimbingState(snapshot);
+
+	TArray<FVector> frameRateTrajectory;
+	movement->SetUseFixedClimbingStep(false);
+	const uint64 frameRateCycles = ClimbFromSnapshot(world, character, snapshot, numFrames, frameRateTrajectory);
+
+	TArray<FVector> fixedStepTrajectory;
+	movement->SetUseFixedClimbingStep(true);
+	const uint64 fixedStepCycles = ClimbFromSnapshot(world, character, snapshot, numFrames, fixedStepTrajectory);
+
+	result.FrameRateMillisecondsPerFrame = frameRateTrajectory.Num() > 0 ? FPlatformTime::ToMilliseconds64(frameRateCycles) / frameRateTrajectory.Num() : 0.f;
+	result.FixedStepMillisecondsPerFrame = fixedStepTrajectory.Num() > 0 ? FPlatformTime::ToMilliseconds64(fixedStepCycles) / fixedStepTrajectory.Num() : 0.f;
+
+	// Fixed steps lag behind by up to a step and may leave the wall on another frame, only the frames both climbed are compared.
+	result.FixedStepDivergence = 0.f;
+	for (int32 frame = 0; frame < FMath::Min(frameRateTrajectory.Num(), fixedStepTrajectory.Num()); ++frame)
+	{
+		result.FixedStepDivergence = FMath::Max(result.FixedStepDivergence, FVector::Dist(frameRateTrajectory[frame], fixedStepTrajectory[frame]));
+	}
+
+	// Start the cost measurement from the same state as without the comparison.
+	movement->SetUseFixedClimbingStep(wasUsingFixedClimbingStep);
+	movement->RestoreClimbingState(snapshot);
+}
+
+uint64 UClimbingCostCommandlet::ClimbFromSnapshot(UWorld* world, ACharacter* character, const FClimbingStateSnapshot& snapshot, int32 numFrames,
+	TArray<FVector>& outTrajectory) const
+{
+	UMyCharacterMovementComponent* movement = Cast<UMyCharacterMovementComponent>(character->GetCharacterMovement());
+
+	movement->RestoreClimbingState(snapshot);
+	movement->ResetClimbingQueryStats();
+
+	outTrajectory.Reserve(numFrames);
+
+	for (int32 frame = 0; frame < numFrames && (movement->IsClimbing() || movement->IsShimmying()); ++frame)
+	{
+		ApplyProbeInput(character, frame, numFrames);
+		TickWorld(world);
+
+		outTrajectory.Add(character->GetActorLocation());
+	}
+
+	return movement->GetClimbingQueryStats().PhysCycles;
+}
+
+void UClimbingCostCommandlet::TickWorld(UWorld* world) const
+{
+	world->Tick(LEVELTICK_All, FrameDeltaTime);
+
+	// Let the climbing assets stream in and their completion delegates run, as the engine loop would.
+	FlushAsyncLoading();
+	FTickableGameObject::TickObjects(world, LEVELTICK_All, false, FrameDeltaTime);
+
+	++GFrameCounter;
+}
+
+bool UClimbingCostCommandlet::WriteCsv(const FString& filePath, const TArray<FProbeResult>& results) const
+{
+	FString csv = TEXT("X,Y,Z,NormalX,NormalY,NormalZ,StartedClimbing,QueriesPerFrame,HitsPerSweep,MillisecondsPerTick,AverageNormalJitter,MaxNormalJitter,RollbackDivergence,FrameRateMillisecondsPerFrame,FixedStepMillisecondsPerFrame,FixedStepDivergence\n");
+
+	for (const FProbeResult& result : results)
+	{
+		const FVector& location = result.Start.Location;
+		const FVector& normal = result.Start.Normal;
+
+		csv += FString::Printf(TEXT("%.1f,%.1f,%.1f,%.3f,%.3f,%.3f,%d,%.2f,%.2f,%.4f,%.3f,%.3f,%.4f,%.4f,%.4f,%.4f\n"),
+			location.X, location.Y, location.Z, normal.X, normal.Y, normal.Z, result.bStartedClimbing ? 1 : 0,
+			result.QueriesPerFrame, result.HitsPerSweep, result.MillisecondsPerTick, result.AverageNormalJitter, result.MaxNormalJitter,
+			result.RollbackDivergence, result.FrameRateMillisecondsPerFrame, result.FixedStepMillisecondsPerFrame, result.FixedStepDivergence);
+	}
+
+	if (FFileHelper::SaveStringToFile(csv, *filePath) == false)
+	{
+		UE_LOG(LogClimbingCost, Error, TEXT("Could not write %s"), *filePath);
+		return false;
+	}
+
+	UE_LOG(LogClimbingCost, Display, TEXT("Wrote %s"), *filePath);
+	return true;
+}
+
+bool UClimbingCostCommandlet::WriteHeatmap(const FString& filePath, const TArray<FProbeResult>& results) const
+{
+	constexpr int32 maxResolution = 1024;
+
+	FBox2D area(ForceInit);
+	float maxCost = 0.f;
+
+	for (const FProbeResult& result : results)
+	{
+		if (result.bStartedClimbing)
+		{
+			area += FVector2D(result.Start.Location);
+			maxCost = FMath::Max(maxCost, result.QueriesPerFrame);
+		}
+	}
+
+	if (area.bIsValid == false || maxCost <= 0.f)
+	{
+		UE_LOG(LogClimbingCost, Warning, TEXT("Nothing could be climbed, no heatmap written"));
+		return true;
+	}
+
+	// Top-down view, each pixel keeps the most expensive probe above it.
+	const FVector2D areaSize = area.GetSize();
+	const int32 width = FMath::Clamp(FMath::CeilToInt(areaSize.X / GridSpacing) + 1, 1, maxResolution);
+	const int32 height = FMath::Clamp(FMath::CeilToInt(areaSize.Y / GridSpacing) + 1, 1, maxResolution);
+
+	TArray<float> pixelCosts;
+	pixelCosts.Init(-1.f, width * height);
+
+	for (const FProbeResult& result : results)
+	{
+		if (result.bStartedClimbing == false)
+		{
+			continue;
+		}
+
+		const FVector2D relativeLocation = (FVector2D(result.Start.Location) - area.Min) / FVector2D::Max(areaSize, FVector2D(1.f, 1.f));
+		const int32 x = FMath::Clamp(FMath::FloorToInt(relativeLocation.X * (width - 1)), 0, width - 1);
+		const int32 y = FMath::Clamp(FMath::FloorToInt(relativeLocation.Y * (height - 1)), 0, height - 1);
+
+		float& pixelCost = pixelCosts[y * width + x];
+		pixelCost = FMath::Max(pixelCost, result.QueriesPerFrame);
+	}
+
+	TArray<FColor> pixels;
+	pixels.Reserve(pixelCosts.Num());
+
+	for (const float pixelCost : pixelCosts)
+	{
+		const FLinearColor color = pixelCost < 0.f ? FLinearColor::Black :
+			FLinearColor::LerpUsingHSV(FLinearColor::Green, FLinearColor::Red, pixelCost / maxCost);
+
+		pixels.Add(color.ToFColor(true));
+	}
+
+	IImageWrapperModule& imageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>(TEXT("ImageWrapper"));
+	TSharedPtr<IImageWrapper> imageWrapper = imageWrapperModule.CreateImageWrapper(EImageFormat::PNG);
+
+	if (imageWrapper.IsValid() == false ||
+		imageWrapper->SetRaw(pixels.GetData(), pixels.Num() * sizeof(FColor), width, height, ERGBFormat::BGRA, 8) == false)
+	{
+		UE_LOG(LogClimbingCost, Error, TEXT("Could not encode the heatmap"));
+		return false;
+	}
+
+	if (FFileHelper::SaveArrayToFile(imageWrapper->GetCompressed(), *filePath) == false)
+	{
+		UE_LOG(LogClimbingCost, Error, TEXT("Could not write %s"), *filePath);
+		return false;
+	}
+
+	UE_LOG(LogClimbingCost, Display, TEXT("Wrote %s (%dx%d, %.1f queries/frame at most)"), *filePath, width, height, maxCost);
+	return true;
+}
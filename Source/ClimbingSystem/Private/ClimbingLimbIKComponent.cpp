@@ -0,0 +1,166 @@
+#include "ClimbingLimbIKComponent.h"
+
+#include "Camera/PlayerCameraManager.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/PlayerController.h"
+#include "MyCharacterMovementComponent.h"
+
+UClimbingLimbIKComponent::UClimbingLimbIKComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+
+	// Place the limbs once the movement component has swept the surface for this frame.
+	PrimaryComponentTick.TickGroup = TG_PostPhysics;
+}
+
+void UClimbingLimbIKComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	const ACharacter* character = Cast<ACharacter>(GetOwner());
+	check(character);
+
+	MovementComponent = Cast<UMyCharacterMovementComponent>(character->GetCharacterMovement());
+	Mesh = character->GetMesh();
+
+	// Limb placement is only visual.
+	if (GetNetMode() == NM_DedicatedServer || MovementComponent == nullptr)
+	{
+		SetComponentTickEnabled(false);
+	}
+}
+
+void UClimbingLimbIKComponent::TickComponent(float deltaTime, ELevelTick tickType, FActorComponentTickFunction* thisTickFunction)
+{
+	Super::TickComponent(deltaTime, tickType, thisTickFunction);
+
+	TimeSinceLastUpdate += deltaTime;
+
+	if (TimeSinceLastUpdate >= GetUpdateInterval())
+	{
+		TimeSinceLastUpdate = 0.f;
+		UpdateTargetPlacements();
+	}
+
+	InterpolatePlacements(deltaTime);
+}
+
+float UClimbingLimbIKComponent::GetUpdateInterval() const
+{
+	const APlayerController* playerController = GetWorld()->GetFirstPlayerController();
+	if (playerController == nullptr || playerController->PlayerCameraManager == nullptr)
+	{
+		return 0.f;
+	}
+
+	const FVector viewLocation = playerController->PlayerCameraManager->GetCameraLocation();
+	const bool isNearViewer = FVector::DistSquared(viewLocation, GetOwner()->GetActorLocation()) <= FMath::Square(NearViewDistance);
+
+	return isNearViewer ? 0.f : FarUpdateInterval;
+}
+
+FName UClimbingLimbIKComponent::GetLimbBoneName(EClimbingLimb limb) const
+{
+	switch (limb)
+	{
+	case EClimbingLimb::HandLeft:
+		return HandLeftBoneName;
+	case EClimbingLimb::HandRight:
+		return HandRightBoneName;
+	case EClimbingLimb::FootLeft:
+		return FootLeftBoneName;
+	case EClimbingLimb::FootRight:
+		return FootRightBoneName;
+	default:
+		return NAME_None;
+	}
+}
+
+void UClimbingLimbIKComponent::UpdateTargetPlacements()
+{
+	const bool isShimmying = MovementComponent->IsShimmying();
+	const bool isOnWall = MovementComponent->IsClimbing() || isShimmying;
+
+	// Shimmying follows the cached ledge without sweeping the wall, its hits are left from before the ledge was grabbed.
+	const TArrayView<const FHitResult> wallHits = isShimmying ? TArrayView<const FHitResult>() : MakeArrayView(MovementComponent->GetClimbWallHits());
+
+	for (uint8 limbIndex = 0; limbIndex < (uint8)EClimbingLimb::MAX; ++limbIndex)
+	{
+		FClimbingLimbPlacement& target = TargetPlacements[limbIndex];
+		const FVector boneLocation = Mesh->GetSocketLocation(GetLimbBoneName((EClimbingLimb)limbIndex));
+
+		target.Alpha = 0.f;
+		target.Location = boneLocation;
+		target.Normal = FVector::ZeroVector;
+
+		if (isOnWall == false)
+		{
+			continue;
+		}
+
+		// Every limb shares the same wall hits, the closest one gives the plane the limb is placed on.
+		const FHitResult* closestHit = nullptr;
+		float closestDistanceSquared = FMath::Square(MaxLimbReach);
+
+		for (const FHitResult& wallHit : wallHits)
+		{
+			const float distanceSquared = FVector::DistSquared(wallHit.ImpactPoint, boneLocation);
+			if (distanceSquared <= closestDistanceSquared)
+			{
+				closestHit = &wallHit;
+				closestDistanceSquared = distanceSquared;
+			}
+		}
+
+		// Fall back on the averaged climbing surface when no hit is close enough, or the ledge's wall face when shimmying.
+		FVector planeNormal = MovementComponent->GetClimbSurfaceNormal();
+		FVector planePoint = MovementComponent->GetClimbSurfacePosition();
+
+		if (closestHit)
+		{
+			planeNormal = closestHit->ImpactNormal;
+			planePoint = closestHit->ImpactPoint;
+		}
+		else if (isShimmying)
+		{
+			planeNormal = MovementComponent->GetLedgeNormal();
+			planePoint = MovementComponent->GetLedgeEdgePosition();
+		}
+
+		if (planeNormal.IsZero())
+		{
+			continue;
+		}
+
+		const float distanceToPlane = FVector::PointPlaneDist(boneLocation, planePoint, planeNormal);
+		if (FMath::Abs(distanceToPlane) > MaxLimbReach)
+		{
+			continue;
+		}
+
+		target.Location = boneLocation - planeNormal * (distanceToPlane - LimbSurfaceOffset);
+		target.Normal = planeNormal;
+		target.Alpha = 1.f;
+	}
+}
+
+void UClimbingLimbIKComponent::InterpolatePlacements(float deltaTime)
+{
+	for (uint8 limbIndex = 0; limbIndex < (uint8)EClimbingLimb::MAX; ++limbIndex)
+	{
+		const FClimbingLimbPlacement& target = TargetPlacements[limbIndex];
+		FClimbingLimbPlacement& current = CurrentPlacements[limbIndex];
+
+		current.Location = FMath::VInterpTo(current.Location, target.Location, deltaTime, PlacementInterpSpeed);
+		current.Normal = FMath::VInterpTo(current.Normal, target.Normal, deltaTime, PlacementInterpSpeed).GetSafeNormal();
+		current.Alpha = FMath::FInterpTo(current.Alpha, target.Alpha, deltaTime, PlacementInterpSpeed);
+	}
+}
+
+FClimbingLimbPlacement UClimbingLimbIKComponent::GetLimbPlacement(EClimbingLimb limb) const
+{
+	check(limb < EClimbingLimb::MAX);
+
+	return CurrentPlacements[(uint8)limb];
+}
@@ -1,8 +1,291 @@
 #include "MyCharacterMovementComponent.h"
 
+#include "ClimbingMath.h"
 #include "ECustomMovement.h"
 #include "Components/CapsuleComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/AssetManager.h"
 #include "GameFramework/Character.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/ScopeExit.h"
+#include "PhysicsEngine/PhysicsSettings.h"
+#include "VisualLogger/VisualLogger.h"
+
+// Climbing probes and states, recorded with the visual logger ("VisLog record" works on servers too).
+DEFINE_LOG_CATEGORY_STATIC(LogClimbing, Log, All);
+
+namespace
+{
+	enum EClimbingProbe : uint8
+	{
+		CPROBE_None = 0,
+		CPROBE_Surface = 1 << 0,
+		CPROBE_Floor = 1 << 1,
+		CPROBE_Ledge = 1 << 2,
+	};
+
+	struct FClimbingQueryPlan
+	{
+		const TCHAR* StateName;
+
+		uint8 Probes;
+
+		/** Seconds between two runs of the probes, 0 to run them every tick. */
+		float Interval;
+	};
+
+	// Indexed by EClimbingState. An idle climber doesn't move so its surface only needs refreshing once in a while,
+	// and the ledge montage drives the character on its own until it ends.
+	constexpr FClimbingQueryPlan ClimbingQueryPlans[] =
+	{
+		{ TEXT("Idle"), CPROBE_Surface | CPROBE_Floor, 0.2f },
+		{ TEXT("Moving"), CPROBE_Surface | CPROBE_Floor | CPROBE_Ledge, 0.f },
+		{ TEXT("Dashing"), CPROBE_Surface | CPROBE_Floor | CPROBE_Ledge, 0.f },
+		{ TEXT("ClimbingLedge"), CPROBE_None, 0.f },
+	};
+
+	static_assert(UE_ARRAY_COUNT(ClimbingQueryPlans) == (uint8)EClimbingState::MAX, "Every climbing state needs a query plan");
+
+	TAutoConsoleVariable<int32> CVarClimbQuality(
+		TEXT("climb.Quality"),
+		3,
+		TEXT("Accuracy of the climbing probes of AI characters, traded for CPU time. Set by the effects scalability group.\n")
+		TEXT("Player characters always climb at epic, they must simulate alike on their client and the server,\n")
+		TEXT("and simulated proxies don't run the climbing physics at all.\n")
+		TEXT(" 0: low, 1: medium, 2: high, 3: epic (default)"),
+		ECVF_Scalability);
+
+	struct FClimbingQualitySettings
+	{
+		/** Scale of the capsule sweeping for wall hits, a smaller one finds fewer hits to process. */
+		float WallSweepScale;
+
+		/** Nearest wall hits the surface is computed from, 0 for all of them. */
+		int32 MaxSurfaceHits;
+
+		float AssistSweepRadius;
+
+		float AssistSweepDistance;
+
+		/** Lower bound of every query plan interval, 0 to let the plans probe every tick. */
+		float MinProbeInterval;
+	};
+
+	// Indexed by climb.Quality, epic is the reference behavior.
+	constexpr FClimbingQualitySettings ClimbingQualitySettings[] =
+	{
+		{ 0.8f, 2, 10.f, 100.f, 1.f / 20.f },
+		{ 0.9f, 4, 8.f, 110.f, 1.f / 30.f },
+		{ 1.f, 8, 6.f, 120.f, 0.f },
+		{ 1.f, 0, 6.f, 120.f, 0.f },
+	};
+
+	const FClimbingQualitySettings& GetClimbingQualitySettings(const ACharacter& character)
+	{
+		// Player characters are simulated on both ends of a connection, where the variable may differ.
+		// Their simulated proxies count as player controlled too, through their replicated player state.
+		if (character.IsPlayerControlled())
+		{
+			return ClimbingQualitySettings[UE_ARRAY_COUNT(ClimbingQualitySettings) - 1];
+		}
+
+		const int32 quality = FMath::Clamp(CVarClimbQuality.GetValueOnGameThread(), 0, (int32)UE_ARRAY_COUNT(ClimbingQualitySettings) - 1);
+		return ClimbingQualitySettings[quality];
+	}
+
+	ClimbingMath::FVec3 ToClimbingVec(const FVector& vector)
+	{
+		return ClimbingMath::FVec3(vector.X, vector.Y, vector.Z);
+	}
+
+	FVector ToFVector(const ClimbingMath::FVec3& vector)
+	{
+		return FVector(vector.X, vector.Y, vector.Z);
+	}
+
+	/** Start time of a climbing probe, only read while the visual logger records so probes cost nothing more otherwise. */
+	uint64 BeginClimbingProbe()
+	{
+#if ENABLE_VISUAL_LOG
+		return FVisualLogger::IsRecording() ? FPlatformTime::Cycles64() : 0;
+#else
+		return 0;
+#endif
+	}
+
+	/** Records a probe's shape from start to end, green when it hit something, with its hit count and duration. */
+	void VLogClimbingProbe(const UObject* logOwner, const TCHAR* probeName, const FVector& start, const FVector& end,
+		const FCollisionShape& shape, int32 numHits, uint64 startCycles)
+	{
+#if ENABLE_VISUAL_LOG
+		if (FVisualLogger::IsRecording() == false)
+		{
+			return;
+		}
+
+		const double milliseconds = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - startCycles);
+		const FColor color = numHits > 0 ? FColor::Green : FColor::Red;
+
+		if (shape.IsCapsule())
+		{
+			// Logged capsules are placed by their base.
+			const FVector base = start - FVector::UpVector * shape.GetCapsuleHalfHeight();
+			UE_VLOG_CAPSULE(logOwner, LogClimbing, Log, base, shape.GetCapsuleHalfHeight(), shape.GetCapsuleRadius(), FQuat::Identity, color, TEXT(""));
+		}
+		else if (shape.IsSphere())
+		{
+			UE_VLOG_LOCATION(logOwner, LogClimbing, Log, end, shape.GetSphereRadius(), color, TEXT(""));
+		}
+
+		UE_VLOG_SEGMENT(logOwner, LogClimbing, Log, start, end, color, TEXT("%s: %d hits, %.3f ms"), probeName, numHits, milliseconds);
+#endif
+	}
+
+	/** Runs the climbing math queries against the world, as the movement component's own traces. */
+	class FWorldClimbingCollision final : public ClimbingMath::ICollisionQuery
+	{
+	public:
+		/** probeName tells the queries apart in the visual logger. */
+		FWorldClimbingCollision(const UCharacterMovementComponent& movement, const FCollisionQueryParams& queryParams, FClimbingQueryStats& queryStats,
+			const TCHAR* probeName)
+			: Movement(movement), QueryParams(queryParams), QueryStats(queryStats), ProbeName(probeName)
+		{
+		}
+
+		virtual bool LineTrace(const ClimbingMath::FVec3& start, const ClimbingMath::FVec3& end, ClimbingMath::FHit& outHit) const override
+		{
+			return Sweep(start, end, FCollisionShape(), outHit);
+		}
+
+		virtual bool SweepSphere(const ClimbingMath::FVec3& start, const ClimbingMath::FVec3& end, double radius, ClimbingMath::FHit& outHit) const override
+		{
+			return Sweep(start, end, FCollisionShape::MakeSphere(radius), outHit);
+		}
+
+		virtual bool SweepCapsule(const ClimbingMath::FVec3& start, const ClimbingMath::FVec3& end, double radius, double halfHeight,
+			ClimbingMath::FHit& outHit) const override
+		{
+			return Sweep(start, end, FCollisionShape::MakeCapsule(radius, halfHeight), outHit);
+		}
+
+	private:
+		bool Sweep(const ClimbingMath::FVec3& start, const ClimbingMath::FVec3& end, const FCollisionShape& shape, ClimbingMath::FHit& outHit) const
+		{
+			++QueryStats.NumQueries;
+			const uint64 startCycles = BeginClimbingProbe();
+
+			// Line shapes make the sweep a line trace.
+			FHitResult hit;
+			const bool isBlocked = Movement.GetWorld()->SweepSingleByChannel(hit, ToFVector(start), ToFVector(end), FQuat::Identity,
+				ECC_WorldStatic, shape, QueryParams);
+
+			VLogClimbingProbe(Movement.GetCharacterOwner(), ProbeName, ToFVector(start), ToFVector(end), shape, isBlocked ? 1 : 0, startCycles);
+
+			if (isBlocked)
+			{
+				outHit.Location = ToClimbingVec(shape.IsLine() ? hit.ImpactPoint : hit.Location);
+				outHit.Normal = ToClimbingVec(hit.Normal);
+				outHit.bWalkable = Movement.IsWalkable(hit);
+			}
+
+			return isBlocked;
+		}
+
+		const UCharacterMovementComponent& Movement;
+		const FCollisionQueryParams& QueryParams;
+		FClimbingQueryStats& QueryStats;
+		const TCHAR* ProbeName;
+	};
+}
+
+/** Sends the climb intent and the dash start to the server along with the move they were input on. */
+class FSavedMove_Climbing : public FSavedMove_Character
+{
+	typedef FSavedMove_Character Super;
+
+public:
+	enum : uint8
+	{
+		FLAG_WantsToClimb = FLAG_Custom_0,
+		FLAG_ClimbDashing = FLAG_Custom_1,
+	};
+
+	virtual void Clear() override
+	{
+		Super::Clear();
+
+		bSavedWantsToClimb = false;
+		bSavedIsClimbDashing = false;
+	}
+
+	virtual void SetMoveFor(ACharacter* character, float inDeltaTime, FVector const& newAccel,
+		FNetworkPredictionData_Client_Character& clientData) override
+	{
+		Super::SetMoveFor(character, inDeltaTime, newAccel, clientData);
+
+		const UMyCharacterMovementComponent* movement = Cast<UMyCharacterMovementComponent>(character->GetCharacterMovement());
+		bSavedWantsToClimb = movement->bWantsToClimb;
+		bSavedIsClimbDashing = movement->bIsClimbDashing;
+	}
+
+	virtual void PrepMoveFor(ACharacter* character) override
+	{
+		Super::PrepMoveFor(character);
+
+		// The dash carries its own timer and direction, only the intent is replayed.
+		Cast<UMyCharacterMovementComponent>(character->GetCharacterMovement())->bWantsToClimb = bSavedWantsToClimb;
+	}
+
+	virtual uint8 GetCompressedFlags() const override
+	{
+		uint8 flags = Super::GetCompressedFlags();
+
+		if (bSavedWantsToClimb)
+		{
+			flags |= FLAG_WantsToClimb;
+		}
+
+		if (bSavedIsClimbDashing)
+		{
+			flags |= FLAG_ClimbDashing;
+		}
+
+		return flags;
+	}
+
+	virtual bool CanCombineWith(const FSavedMovePtr& newMove, ACharacter* character, float maxDelta) const override
+	{
+		const FSavedMove_Climbing* newClimbingMove = static_cast<const FSavedMove_Climbing*>(newMove.Get());
+
+		if (bSavedWantsToClimb != newClimbingMove->bSavedWantsToClimb || bSavedIsClimbDashing != newClimbingMove->bSavedIsClimbDashing)
+		{
+			return false;
+		}
+
+		return Super::CanCombineWith(newMove, character, maxDelta);
+	}
+
+private:
+	uint8 bSavedWantsToClimb : 1;
+
+	uint8 bSavedIsClimbDashing : 1;
+};
+
+class FNetworkPredictionData_Client_Climbing : public FNetworkPredictionData_Client_Character
+{
+	typedef FNetworkPredictionData_Client_Character Super;
+
+public:
+	explicit FNetworkPredictionData_Client_Climbing(const UCharacterMovementComponent& clientMovement)
+		: Super(clientMovement)
+	{
+	}
+
+	virtual FSavedMovePtr AllocateNewMove() override
+	{
+		return FSavedMovePtr(new FSavedMove_Climbing());
+	}
+};
 
 UMyCharacterMovementComponent::UMyCharacterMovementComponent()
 {
@@ -26,24 +309,110 @@ void UMyCharacterMovementComponent::BeginPlay()
 	AnimInstance = GetCharacterOwner()->GetMesh()->GetAnimInstance();
 
 	ClimbQueryParams.AddIgnoredActor(GetOwner());
+}
+
+void UMyCharacterMovementComponent::EndPlay(const EEndPlayReason::Type endPlayReason)
+{
+	ReleaseClimbingAssets();
+
+	Super::EndPlay(endPlayReason);
+}
+
+void UMyCharacterMovementComponent::TickComponent(float deltaTime, ELevelTick tickType, FActorComponentTickFunction* thisTickFunction)
+{
+	Super::TickComponent(deltaTime, tickType, thisTickFunction);
+
+	const bool isOnWall = IsClimbing() || IsShimmying();
+
+	// The climbing query plan sweeps the surface itself and shimmying follows the cached ledge.
+	// Simulated proxies never run the climbing physics though, their limbs are placed on the hits swept here.
+	if (isOnWall == false || CharacterOwner->GetLocalRole() == ROLE_SimulatedProxy)
+	{
+		SweepAndStoreWallHits();
+	}
 
-	if (ClimbDashCurve)
+	if (isOnWall == false)
+	{
+		UpdateClimbStartPrediction(deltaTime);
+	}
+
+	UpdateClimbingAssets(deltaTime);
+}
+
+void UMyCharacterMovementComponent::UpdateClimbingAssets(float deltaTime)
+{
+	const bool isNearClimbableSurface = CurrentWallHits.IsEmpty() == false || IsClimbing() || IsShimmying();
+
+	if (isNearClimbableSurface)
+	{
+		TimeAwayFromClimbableSurface = 0.f;
+
+		if (ClimbingAssetsHandle.IsValid() == false)
+		{
+			RequestClimbingAssets();
+		}
+
+		return;
+	}
+
+	TimeAwayFromClimbableSurface += deltaTime;
+
+	if (TimeAwayFromClimbableSurface >= ClimbingAssetsReleaseDelay)
+	{
+		ReleaseClimbingAssets();
+	}
+}
+
+void UMyCharacterMovementComponent::RequestClimbingAssets()
+{
+	TArray<FSoftObjectPath> assetPaths;
+
+	if (LedgeClimbMontage.IsNull() == false)
+	{
+		assetPaths.Add(LedgeClimbMontage.ToSoftObjectPath());
+	}
+
+	if (ClimbDashCurve.IsNull() == false)
+	{
+		assetPaths.Add(ClimbDashCurve.ToSoftObjectPath());
+	}
+
+	if (assetPaths.IsEmpty())
+	{
+		return;
+	}
+
+	ClimbingAssetsHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(assetPaths,
+		FStreamableDelegate::CreateUObject(this, &UMyCharacterMovementComponent::OnClimbingAssetsLoaded));
+}
+
+void UMyCharacterMovementComponent::OnClimbingAssetsLoaded()
+{
+	// Dashing stays unavailable until the curve is loaded.
+	if (const UCurveFloat* climbDashCurve = ClimbDashCurve.Get())
 	{
 		float minTime;
-		ClimbDashCurve->GetTimeRange(minTime, ClimbDashDuration);
+		climbDashCurve->GetTimeRange(minTime, ClimbDashDuration);
 	}
 }
 
-void UMyCharacterMovementComponent::TickComponent(float deltaTime, ELevelTick tickType, FActorComponentTickFunction* thisTickFunction)
+void UMyCharacterMovementComponent::ReleaseClimbingAssets()
 {
-	Super::TickComponent(deltaTime, tickType, thisTickFunction);
+	if (ClimbingAssetsHandle.IsValid() == false)
+	{
+		return;
+	}
 
-	SweepAndStoreWallHits();
+	ClimbingAssetsHandle->ReleaseHandle();
+	ClimbingAssetsHandle.Reset();
+
+	ClimbDashDuration = 0.f;
 }
 
 void UMyCharacterMovementComponent::SweepAndStoreWallHits()
 {
-	const FCollisionShape collisionShape = FCollisionShape::MakeCapsule(CollisionCapsuleRadius, CollisionCapsuleHalfHeight);
+	const float sweepScale = GetClimbingQualitySettings(*CharacterOwner).WallSweepScale;
+	const FCollisionShape collisionShape = FCollisionShape::MakeCapsule(CollisionCapsuleRadius * sweepScale, CollisionCapsuleHalfHeight * sweepScale);
 
 	const FVector startOffset = UpdatedComponent->GetForwardVector() * DistanceFromSurface;
 	const FVector endOffset = (CurrentClimbingNormal.IsZero() ? UpdatedComponent->GetForwardVector() : -CurrentClimbingNormal) * FMath::Max(CollisionCapsuleRadius, CollisionCapsuleHalfHeight);
@@ -53,73 +422,106 @@ void UMyCharacterMovementComponent::SweepAndStoreWallHits()
 	const FVector end = start + endOffset;
 
 	TArray<FHitResult> hits;
+	++QueryStats.NumQueries;
+	const uint64 startCycles = BeginClimbingProbe();
 	const bool hitWall = GetWorld()->SweepMultiByChannel(hits, start, end, FQuat::Identity,
 		ECC_WorldStatic, collisionShape, ClimbQueryParams);
 
-#if 0
-	DrawDebugCapsule(GetWorld(), start, collisionShape.GetCapsuleHalfHeight(), collisionShape.GetCapsuleRadius(), UpdatedComponent->GetComponentQuat(), FColor::Emerald, false, -1.0f, 0U, 2.f);
-#endif
+	VLogClimbingProbe(CharacterOwner, TEXT("WallSweep"), start, end, collisionShape, hits.Num(), startCycles);
+
+	++QueryStats.NumWallSweeps;
+	QueryStats.NumWallHits += hits.Num();
 
 	hitWall ? CurrentWallHits = hits : CurrentWallHits.Reset();
 }
 
 bool UMyCharacterMovementComponent::CanStartClimbing()
 {
-	for (FHitResult& hit : CurrentWallHits)
+	TArray<ClimbingMath::FHit, TInlineAllocator<16>> wallHits;
+	for (const FHitResult& hit : CurrentWallHits)
 	{
-		const FVector horizontalNormal = hit.Normal.GetSafeNormal2D();
-
-		const float horizontalDot = FVector::DotProduct(UpdatedComponent->GetForwardVector(), -horizontalNormal);
-		const float verticalDot = FVector::DotProduct(hit.Normal, horizontalNormal);
-
-		const float horizontalDegrees = FMath::RadiansToDegrees(FMath::Acos(horizontalDot));
-
-		const bool isCeiling = FMath::IsNearlyZero(verticalDot);
-		const bool onWalkableFloor = IsWalkable(hit);
-
-		if (horizontalDegrees <= MinHorizontalDegreesToStartClimbing &&
-			isCeiling == false && onWalkableFloor == false && IsFacingSurface(verticalDot))
-		{
-			return true;
-		}
+		ClimbingMath::FHit& wallHit = wallHits.AddDefaulted_GetRef();
+		wallHit.Location = ToClimbingVec(hit.ImpactPoint);
+		wallHit.Normal = ToClimbingVec(hit.Normal);
+		wallHit.bWalkable = IsWalkable(hit);
 	}
 
-	return false;
+	const FWorldClimbingCollision collision(*this, ClimbQueryParams, QueryStats, TEXT("FacingSurfaceTrace"));
+
+	return ClimbingMath::CanStartClimbing(collision, ToClimbingVec(GetClimbingEyeLocation()), ToClimbingVec(UpdatedComponent->GetForwardVector()),
+		wallHits.GetData(), wallHits.Num(), MinHorizontalDegreesToStartClimbing);
 }
 
-bool UMyCharacterMovementComponent::IsFacingSurface(const float steepness) const
+FVector UMyCharacterMovementComponent::GetClimbingEyeLocation(const float heightOffset) const
 {
-	constexpr float baseLength = 80;
-	const float steepnessMultiplier = 1 + (1 - steepness) * 5;
+	const float baseEyeHeight = CharacterOwner->BaseEyeHeight;
+	const float eyeHeightOffset = IsClimbing() || IsShimmying() ? baseEyeHeight + ClimbingCollisionShrinkAmount + heightOffset : baseEyeHeight;
 
-	FHitResult surfaceHit;
-	return EyeHeightTrace(surfaceHit, baseLength * steepnessMultiplier);
+	return UpdatedComponent->GetComponentLocation() + UpdatedComponent->GetUpVector() * eyeHeightOffset;
 }
 
-bool UMyCharacterMovementComponent::EyeHeightTrace(FHitResult& outHit, const float traceDistance, const float heightOffset) const
+void UMyCharacterMovementComponent::UpdateClimbStartPrediction(float deltaTime)
 {
-	const float baseEyeHeight = CharacterOwner->BaseEyeHeight;
-	const float eyeHeightOffset = IsClimbing() ? baseEyeHeight + ClimbingCollisionShrinkAmount + heightOffset : baseEyeHeight;
+	TimeSinceClimbStartPrediction += deltaTime;
 
-	const FVector start = UpdatedComponent->GetComponentLocation() + UpdatedComponent->GetUpVector() * eyeHeightOffset;
-	const FVector end = start + (UpdatedComponent->GetForwardVector() * traceDistance);
+	// Only characters that can press climb need it, and away from walls CanStartClimbing has nothing to trace.
+	// Invalidated so that reaching a wall evaluates it right away.
+	if (CharacterOwner->IsLocallyControlled() == false || CurrentWallHits.Num() == 0)
+	{
+		bCanStartClimbingPrediction = false;
+		TimeSinceClimbStartPrediction = TNumericLimits<float>::Max();
+		return;
+	}
+
+	// Refreshed at half the validity window, so a press always finds a valid prediction.
+	if (TimeSinceClimbStartPrediction >= ClimbStartPredictionValidity * 0.5f)
+	{
+		bCanStartClimbingPrediction = CanStartClimbing();
+		TimeSinceClimbStartPrediction = 0.f;
+	}
+}
 
-	return GetWorld()->LineTraceSingleByChannel(outHit, start, end, ECC_WorldStatic, ClimbQueryParams);
+bool UMyCharacterMovementComponent::HasValidClimbStartPrediction() const
+{
+	// Only a recent success is trusted, the wall may have come into reach since a failure.
+	return bCanStartClimbingPrediction && TimeSinceClimbStartPrediction <= ClimbStartPredictionValidity;
 }
 
-void UMyCharacterMovementComponent::OnMovementUpdated(float deltaTime, const FVector& oldLocation, const FVector& oldVelocity)
+void UMyCharacterMovementComponent::UpdateCharacterStateBeforeMovement(float deltaSeconds)
 {
-	if (bWantsToClimb)
+	// Before the physics rather than after it, so the update following the climb input already climbs.
+	if (bWantsToClimb && IsClimbing() == false && IsShimmying() == false)
 	{
 		SetMovementMode(EMovementMode::MOVE_Custom, ECustomMovementMode::CMOVE_Climbing);
 	}
 
-	Super::OnMovementUpdated(deltaTime, oldLocation, oldVelocity);
+	Super::UpdateCharacterStateBeforeMovement(deltaSeconds);
 }
 
 void UMyCharacterMovementComponent::OnMovementModeChanged(EMovementMode previousMovementMode, uint8 previousCustomMode)
 {
+	// Climbing and shimmying share the same collision setup, switching between them keeps it as is.
+	const bool isOnWall = IsClimbing() || IsShimmying();
+	const bool wasOnWall = previousMovementMode == MOVE_Custom &&
+		(previousCustomMode == CMOVE_Climbing || previousCustomMode == CMOVE_Shimmying);
+
 	if (IsClimbing())
+	{
+		// Run every probe on the first climbing update.
+		PreviousClimbingState = EClimbingState::MAX;
+	}
+
+	if (isOnWall == false)
+	{
+		SetClimbingBase(nullptr);
+	}
+
+	if (isOnWall != wasOnWall)
+	{
+		ResetClimbingStepPresentation();
+	}
+
+	if (isOnWall && wasOnWall == false)
 	{
 		bOrientRotationToMovement = false;
 
@@ -127,8 +529,7 @@ void UMyCharacterMovementComponent::OnMovementModeChanged(EMovementMode previous
 		capsule->SetCapsuleHalfHeight(capsule->GetUnscaledCapsuleHalfHeight() - ClimbingCollisionShrinkAmount);
 	}
 
-	const bool wasClimbing = previousMovementMode == MOVE_Custom && previousCustomMode == CMOVE_Climbing;
-	if (wasClimbing)
+	if (wasOnWall && isOnWall == false)
 	{
 		bOrientRotationToMovement = true;
 
@@ -151,12 +552,157 @@ void UMyCharacterMovementComponent::SetRotationToStand() const
 
 void UMyCharacterMovementComponent::PhysCustom(float deltaTime, int32 iterations)
 {
-	if (CustomMovementMode == ECustomMovementMode::CMOVE_Climbing)
+	const uint64 startCycles = FPlatformTime::Cycles64();
+
+	if (bUseFixedClimbingStep)
+	{
+		PhysFixedClimbingSteps(deltaTime, iterations);
+	}
+	else
+	{
+		PhysClimbingModes(deltaTime, iterations);
+	}
+
+	++QueryStats.NumPhysTicks;
+	QueryStats.PhysCycles += FPlatformTime::Cycles64() - startCycles;
+
+	Super::PhysCustom(deltaTime, iterations);
+}
+
+void UMyCharacterMovementComponent::PhysClimbingModes(float deltaTime, int32 iterations)
+{
+	if (CustomMovementMode == ECustomMovementMode::CMOVE_Climbing)
+	{
+		PhysClimbing(deltaTime, iterations);
+	}
+	else if (CustomMovementMode == ECustomMovementMode::CMOVE_Shimmying)
+	{
+		PhysShimmying(deltaTime, iterations);
+	}
+}
+
+void UMyCharacterMovementComponent::PhysFixedClimbingSteps(float deltaTime, int32 iterations)
+{
+	const float step = GetClimbingFixedTimeStep();
+	ClimbingStepAccumulator += deltaTime;
+
+	for (int32 stepIndex = 0; stepIndex < MaxClimbingStepsPerFrame && ClimbingStepAccumulator >= step; ++stepIndex)
+	{
+		PreviousClimbingStepLocation = UpdatedComponent->GetComponentLocation();
+		PreviousClimbingStepRotation = UpdatedComponent->GetComponentQuat();
+		ClimbingStepAccumulator -= step;
+
+		PhysClimbingModes(step, iterations);
+
+		// Leaving the wall already started the next mode's physics, and reset the steps.
+		if (IsClimbing() == false && IsShimmying() == false)
+		{
+			return;
+		}
+	}
+
+	// Don't spiral into ever more steps per frame when the frame rate can't keep up.
+	ClimbingStepAccumulator = FMath::Min(ClimbingStepAccumulator, step);
+
+	UpdateClimbingStepPresentation();
+}
+
+float UMyCharacterMovementComponent::GetClimbingFixedTimeStep() const
+{
+	if (ClimbingFixedTimeStep > 0.f)
+	{
+		return FMath::Max(ClimbingFixedTimeStep, MIN_TICK_TIME);
+	}
+
+	// The async physics step is only meaningful when physics actually ticks asynchronously.
+	const UPhysicsSettings* physicsSettings = UPhysicsSettings::Get();
+	const float step = physicsSettings->bTickPhysicsAsync ? physicsSettings->AsyncFixedTimeStepSize : 1.f / 60.f;
+
+	return FMath::Max(step, MIN_TICK_TIME);
+}
+
+bool UMyCharacterMovementComponent::ShouldPresentClimbingSteps() const
+{
+	// A listen server smooths the meshes of remote players itself, and a dedicated server has nothing to present.
+	const bool isRemoteOnListenServer = IsNetMode(NM_ListenServer) && CharacterOwner->IsLocallyControlled() == false;
+
+	return CharacterOwner->GetMesh() != nullptr && IsNetMode(NM_DedicatedServer) == false && isRemoteOnListenServer == false;
+}
+
+void UMyCharacterMovementComponent::UpdateClimbingStepPresentation() const
+{
+	if (ShouldPresentClimbingSteps() == false)
+	{
+		return;
+	}
+
+	USkeletalMeshComponent* mesh = CharacterOwner->GetMesh();
+
+	// The capsule holds the last simulated step, the mesh is placed between it and the step before,
+	// by how far the frame went into the next step.
+	const float alpha = FMath::Clamp(ClimbingStepAccumulator / GetClimbingFixedTimeStep(), 0.f, 1.f);
+
+	const FVector location = UpdatedComponent->GetComponentLocation();
+	const FQuat rotation = UpdatedComponent->GetComponentQuat();
+	const FVector presentedLocation = FMath::Lerp(PreviousClimbingStepLocation, location, alpha);
+	const FQuat presentedRotation = FQuat::Slerp(PreviousClimbingStepRotation, rotation, alpha);
+
+	const FQuat relativeRotation = rotation.Inverse() * presentedRotation;
+	const FVector relativeLocation = rotation.UnrotateVector(presentedLocation - location) + relativeRotation.RotateVector(CharacterOwner->GetBaseTranslationOffset());
+
+	mesh->SetRelativeLocationAndRotation(relativeLocation, relativeRotation * CharacterOwner->GetBaseRotationOffset());
+}
+
+void UMyCharacterMovementComponent::ResetClimbingStepPresentation()
+{
+	ClimbingStepAccumulator = 0.f;
+	PreviousClimbingStepLocation = UpdatedComponent->GetComponentLocation();
+	PreviousClimbingStepRotation = UpdatedComponent->GetComponentQuat();
+
+	if (ShouldPresentClimbingSteps())
+	{
+		CharacterOwner->GetMesh()->SetRelativeLocationAndRotation(CharacterOwner->GetBaseTranslationOffset(), CharacterOwner->GetBaseRotationOffset());
+	}
+}
+
+void UMyCharacterMovementComponent::OnClientCorrectionReceived(FNetworkPredictionData_Client_Character& clientData, float timeStamp,
+	FVector newLocation, FVector newVelocity, UPrimitiveComponent* newBase, FName newBaseBoneName, bool hasBase, bool baseRelativePosition,
+	uint8 serverMovementMode)
+{
+	Super::OnClientCorrectionReceived(clientData, timeStamp, newLocation, newVelocity, newBase, newBaseBoneName, hasBase, baseRelativePosition,
+		serverMovementMode);
+
+	// The server's step phase isn't replicated, start the steps over from the corrected location rather than a stale phase.
+	if (bUseFixedClimbingStep)
+	{
+		ResetClimbingStepPresentation();
+	}
+}
+
+FNetworkPredictionData_Client* UMyCharacterMovementComponent::GetPredictionData_Client() const
+{
+	if (ClientPredictionData == nullptr)
+	{
+		UMyCharacterMovementComponent* mutableThis = const_cast<UMyCharacterMovementComponent*>(this);
+		mutableThis->ClientPredictionData = new FNetworkPredictionData_Client_Climbing(*this);
+	}
+
+	return ClientPredictionData;
+}
+
+void UMyCharacterMovementComponent::UpdateFromCompressedFlags(uint8 flags)
+{
+	Super::UpdateFromCompressedFlags(flags);
+
+	// Read on the server before each move, the client checked the wall when the input came in.
+	// UpdateCharacterStateBeforeMovement then enters climbing as it does for the owning client.
+	bWantsToClimb = (flags & FSavedMove_Climbing::FLAG_WantsToClimb) != 0;
+
+	// The flag stays set for the whole dash, TryClimbDashing ignores it while the server's dash runs, both end on the same move.
+	if ((flags & FSavedMove_Climbing::FLAG_ClimbDashing) != 0)
 	{
-		PhysClimbing(deltaTime, iterations);
+		TryClimbDashing();
 	}
-
-	Super::PhysCustom(deltaTime, iterations);
 }
 
 void UMyCharacterMovementComponent::UpdateClimbDashState(float deltaTime)
@@ -181,9 +727,27 @@ void UMyCharacterMovementComponent::PhysClimbing(float deltaTime, int32 iteratio
 		return;
 	}
 
-	ComputeSurfaceInfo();
+	const EClimbingState state = GetClimbingState();
+	const uint8 probes = GetDueClimbingProbes(state, deltaTime);
+	const int32 previousNumQueries = QueryStats.NumQueries;
+
+	ON_SCOPE_EXIT
+	{
+		QueryStats.NumStateQueries[(uint8)state] += QueryStats.NumQueries - previousNumQueries;
+		++QueryStats.NumStateTicks[(uint8)state];
+
+		UE_VLOG(CharacterOwner, LogClimbing, Log, TEXT("%s: %d queries"), ClimbingQueryPlans[(uint8)state].StateName, QueryStats.NumQueries - previousNumQueries);
+	};
+
+	ApplyClimbingBaseMovement();
+
+	if (probes & CPROBE_Surface)
+	{
+		SweepAndStoreWallHits();
+		ComputeSurfaceInfo();
+	}
 
-	if (ShouldStopClimbing() || ClimbDownToFloor())
+	if (ShouldStopClimbing() || ((probes & CPROBE_Floor) && ClimbDownToFloor()))
 	{
 		StopClimbing(deltaTime, iterations);
 		return;
@@ -201,7 +765,11 @@ void UMyCharacterMovementComponent::PhysClimbing(float deltaTime, int32 iteratio
 
 	MoveAlongClimbingSurface(deltaTime);
 
-	TryClimbUpLedge();
+	// Finishing the ledge climb doesn't trace, it only waits for the montage.
+	if (bIsClimbingLedge || (probes & CPROBE_Ledge))
+	{
+		TryClimbUpLedge();
+	}
 
 	if (HasAnimRootMotion() == false && CurrentRootMotion.HasOverrideVelocity() == false)
 	{
@@ -211,34 +779,148 @@ void UMyCharacterMovementComponent::PhysClimbing(float deltaTime, int32 iteratio
 	SnapToClimbingSurface(deltaTime);
 }
 
+EClimbingState UMyCharacterMovementComponent::GetClimbingState() const
+{
+	if (bIsClimbingLedge)
+	{
+		return EClimbingState::ClimbingLedge;
+	}
+
+	if (bIsClimbDashing)
+	{
+		return EClimbingState::Dashing;
+	}
+
+	return Acceleration.IsNearlyZero() && Velocity.IsNearlyZero() ? EClimbingState::Idle : EClimbingState::Moving;
+}
+
+uint8 UMyCharacterMovementComponent::GetDueClimbingProbes(EClimbingState state, float deltaTime)
+{
+	const FClimbingQueryPlan& plan = ClimbingQueryPlans[(uint8)state];
+
+	TimeSinceClimbingProbes += deltaTime;
+
+	// Entering a state always runs its probes, so it never starts from another state's stale results.
+	const float interval = FMath::Max(plan.Interval, GetClimbingQualitySettings(*CharacterOwner).MinProbeInterval);
+	const bool areProbesDue = state != PreviousClimbingState || TimeSinceClimbingProbes >= interval;
+	PreviousClimbingState = state;
+
+	if (areProbesDue == false)
+	{
+		return CPROBE_None;
+	}
+
+	TimeSinceClimbingProbes = 0.f;
+	return plan.Probes;
+}
+
 void UMyCharacterMovementComponent::ComputeSurfaceInfo()
 {
-	CurrentClimbingNormal = FVector::ZeroVector;
-	CurrentClimbingPosition = FVector::ZeroVector;
+	const FClimbingQualitySettings& quality = GetClimbingQualitySettings(*CharacterOwner);
+
+	// Sweep hits are sorted by distance, the nearest ones are kept.
+	const int32 numSurfaceHits = quality.MaxSurfaceHits > 0 ? FMath::Min(quality.MaxSurfaceHits, CurrentWallHits.Num()) : CurrentWallHits.Num();
+
+	TArray<ClimbingMath::FVec3, TInlineAllocator<16>> wallImpactPoints;
+	for (int32 hitIndex = 0; hitIndex < numSurfaceHits; ++hitIndex)
+	{
+		wallImpactPoints.Add(ToClimbingVec(CurrentWallHits[hitIndex].ImpactPoint));
+	}
+
+	const FWorldClimbingCollision collision(*this, ClimbQueryParams, QueryStats, TEXT("AssistSweep"));
+	const ClimbingMath::FSurfaceInfo surface = ClimbingMath::ComputeSurfaceInfo(collision,
+		ToClimbingVec(UpdatedComponent->GetComponentLocation()), wallImpactPoints.GetData(), wallImpactPoints.Num(),
+		quality.AssistSweepRadius, quality.AssistSweepDistance);
+
+	CurrentClimbingPosition = ToFVector(surface.Position);
+	CurrentClimbingNormal = ToFVector(surface.Normal);
+
+	SetClimbingBase(CurrentWallHits.Num() > 0 ? CurrentWallHits[0].GetComponent() : nullptr);
+}
+
+void UMyCharacterMovementComponent::SetClimbingBase(UPrimitiveComponent* base)
+{
+	// Static and stationary geometry never moves, there is nothing to follow.
+	UPrimitiveComponent* newBase = base != nullptr && base->Mobility == EComponentMobility::Movable ? base : nullptr;
+	UPrimitiveComponent* oldBase = ClimbingBase.Get();
+
+	// Like a movement base, the climbed base ticks first so its movement this frame is carried right away.
+	if (newBase != oldBase)
+	{
+		// Unless the character also stands on it, then the dependency is the movement base's.
+		if (oldBase != nullptr && oldBase != CharacterOwner->GetMovementBase())
+		{
+			MovementBaseUtility::RemoveTickDependency(PrimaryComponentTick, oldBase);
+		}
+
+		if (newBase != nullptr)
+		{
+			MovementBaseUtility::AddTickDependency(PrimaryComponentTick, newBase);
+		}
+	}
+
+	ClimbingBase = newBase;
+
+	if (newBase != nullptr)
+	{
+		ClimbingBaseTransform = newBase->GetComponentTransform();
+	}
+}
+
+void UMyCharacterMovementComponent::ApplyClimbingBaseMovement()
+{
+	const UPrimitiveComponent* base = ClimbingBase.Get();
+	if (base == nullptr)
+	{
+		return;
+	}
 
-	if (CurrentWallHits.IsEmpty())
+	const FTransform& baseTransform = base->GetComponentTransform();
+	if (baseTransform.Equals(ClimbingBaseTransform))
 	{
 		return;
 	}
 
-	const FVector start = UpdatedComponent->GetComponentLocation();
-	const FCollisionShape collisionSphere = FCollisionShape::MakeSphere(6);
-	constexpr float sweepDistance = 120;
+	// Only the base moved: the cached surface state is carried with it rather than queried again,
+	// so the probes that follow only sweep the character's own movement.
+	const auto carryPosition = [&](const FVector& position)
+	{
+		return baseTransform.TransformPosition(ClimbingBaseTransform.InverseTransformPosition(position));
+	};
+
+	const auto carryDirection = [&](const FVector& direction)
+	{
+		return baseTransform.TransformVectorNoScale(ClimbingBaseTransform.InverseTransformVectorNoScale(direction));
+	};
+
+	const FVector location = UpdatedComponent->GetComponentLocation();
+	const FQuat deltaRotation = baseTransform.GetRotation() * ClimbingBaseTransform.GetRotation().Inverse();
+
+	MoveUpdatedComponent(carryPosition(location) - location, deltaRotation * UpdatedComponent->GetComponentQuat(), false);
 
-	for (const FHitResult& wallHit : CurrentWallHits)
+	CurrentClimbingPosition = carryPosition(CurrentClimbingPosition);
+	CurrentClimbingNormal = carryDirection(CurrentClimbingNormal);
+	CurrentClimbingDirection = carryDirection(CurrentClimbingDirection);
+
+	if (TargetLedgePosition.IsZero() == false)
 	{
-		const FVector end = start + (wallHit.ImpactPoint - start).GetSafeNormal() * sweepDistance;
+		TargetLedgePosition = carryPosition(TargetLedgePosition);
+	}
 
-		FHitResult AssistHit;
-		GetWorld()->SweepSingleByChannel(AssistHit, start, end, FQuat::Identity,
-			ECC_WorldStatic, collisionSphere, ClimbQueryParams);
+	if (IsShimmying())
+	{
+		LedgeEdgePosition = carryPosition(LedgeEdgePosition);
+		LedgeDirection = carryDirection(LedgeDirection);
+		LedgeNormal = carryDirection(LedgeNormal);
+	}
 
-		CurrentClimbingPosition += AssistHit.Location;
-		CurrentClimbingNormal += AssistHit.Normal;
+	for (FHitResult& wallHit : CurrentWallHits)
+	{
+		wallHit.ImpactPoint = carryPosition(wallHit.ImpactPoint);
+		wallHit.ImpactNormal = carryDirection(wallHit.ImpactNormal);
 	}
 
-	CurrentClimbingPosition /= CurrentWallHits.Num();
-	CurrentClimbingNormal = CurrentClimbingNormal.GetSafeNormal();
+	ClimbingBaseTransform = baseTransform;
 }
 
 bool UMyCharacterMovementComponent::ShouldStopClimbing() const
@@ -285,7 +967,13 @@ bool UMyCharacterMovementComponent::CheckFloor(FHitResult& floorHit) const
 	const FVector start = UpdatedComponent->GetComponentLocation() + (UpdatedComponent->GetUpVector() * -20);
 	const FVector end = start + FVector::DownVector * FloorCheckDistance;
 
-	return GetWorld()->LineTraceSingleByChannel(floorHit, start, end, ECC_WorldStatic, ClimbQueryParams);
+	++QueryStats.NumQueries;
+	const uint64 startCycles = BeginClimbingProbe();
+	const bool isBlocked = GetWorld()->LineTraceSingleByChannel(floorHit, start, end, ECC_WorldStatic, ClimbQueryParams);
+
+	VLogClimbingProbe(CharacterOwner, TEXT("FloorTrace"), start, end, FCollisionShape(), isBlocked ? 1 : 0, startCycles);
+
+	return isBlocked;
 }
 
 bool UMyCharacterMovementComponent::HasReachedEdge() const
@@ -293,59 +981,29 @@ bool UMyCharacterMovementComponent::HasReachedEdge() const
 	const UCapsuleComponent* capsule = CharacterOwner->GetCapsuleComponent();
 	const float traceDistance = capsule->GetUnscaledCapsuleRadius() * 2 + DistanceFromSurface;
 
-	FHitResult surfaceHit;
-	return EyeHeightTrace(surfaceHit, traceDistance, LedgeEyeHeightOffset) == false || IsWalkable(surfaceHit);
+	const FWorldClimbingCollision collision(*this, ClimbQueryParams, QueryStats, TEXT("EdgeTrace"));
+
+	return ClimbingMath::HasReachedEdge(collision, ToClimbingVec(GetClimbingEyeLocation(LedgeEyeHeightOffset)),
+		ToClimbingVec(UpdatedComponent->GetForwardVector()), traceDistance);
 }
 
 bool UMyCharacterMovementComponent::CanMoveToLedgeClimbLocation()
 {
 	const UCapsuleComponent* capsule = CharacterOwner->GetCapsuleComponent();
 	const float baseEyeHeight = CharacterOwner->BaseEyeHeight;
-	const float eyeHeightOffset = IsClimbing() ? baseEyeHeight + ClimbingCollisionShrinkAmount + LedgeEyeHeightOffset : baseEyeHeight;
-
-	// take steepness into account, the eyes will be closer to the ledge on a ramp than a wall as the collider is rotated
-	const FVector forward = UpdatedComponent->GetForwardVector();
-	const float upZAxis = UpdatedComponent->GetUpVector().Z;
-	// the more forwardZAxis tends towards 0 (facing a wall), the more we need to adjust horizontally based on the capsule radius
-	const float wallDistance = (1.f - FMath::Abs(forward.Z)) * (capsule->GetUnscaledCapsuleRadius() * 2 + DistanceFromSurface);
-	// the more forwardZAxis tends towards -1, the more we need to adjust horizontally based on the capsule height (to compensate for the steepness)
-	const float steepCorrection = -forward.Z * (capsule->GetUnscaledCapsuleHalfHeight() + eyeHeightOffset) * (forward.Z <= 0.f ? 1.f : 0.25f);
-	const float distanceToClimbLedge = wallDistance + steepCorrection;
+	const float eyeHeightOffset = IsClimbing() || IsShimmying() ? baseEyeHeight + ClimbingCollisionShrinkAmount + LedgeEyeHeightOffset : baseEyeHeight;
 
-	const FVector horizontalOffset = FVector(forward.X * distanceToClimbLedge, forward.Y * distanceToClimbLedge, 0.);
-	const FVector verticalOffset = FVector::UpVector * (capsule->GetUnscaledCapsuleHalfHeight() + eyeHeightOffset * upZAxis);
+	const ClimbingMath::FLedgeClimbTarget target = ClimbingMath::ComputeLedgeClimbTarget(
+		ToClimbingVec(UpdatedComponent->GetComponentLocation()), ToClimbingVec(UpdatedComponent->GetForwardVector()),
+		UpdatedComponent->GetUpVector().Z, capsule->GetUnscaledCapsuleRadius(), capsule->GetUnscaledCapsuleHalfHeight(),
+		eyeHeightOffset, DistanceFromSurface);
 
-	TargetLedgePosition = UpdatedComponent->GetComponentLocation() + horizontalOffset + verticalOffset;
+	TargetLedgePosition = ToFVector(target.Position);
 
-	if (IsLocationWalkable(TargetLedgePosition) == false)
-	{
-		return false;
-	}
-
-	FHitResult capsuleHit;
-	const FVector capsuleStartCheck = TargetLedgePosition - horizontalOffset;
-
-	const bool isBlocked = GetWorld()->SweepSingleByChannel(capsuleHit, capsuleStartCheck, TargetLedgePosition,
-		FQuat::Identity, ECC_WorldStatic, capsule->GetCollisionShape(), ClimbQueryParams);
-
-	return isBlocked == false || IsWalkable(capsuleHit);
-}
-
-bool UMyCharacterMovementComponent::IsLocationWalkable(const FVector& checkLocation) const
-{
-	const UCapsuleComponent* capsule = CharacterOwner->GetCapsuleComponent();
-
-	const FVector checkEnd = checkLocation + (FVector::DownVector * capsule->GetUnscaledCapsuleHalfHeight() * 1.5f);
-
-	FHitResult ledgeHit;
-	GetWorld()->LineTraceSingleByChannel(ledgeHit, checkLocation, checkEnd,
-		ECC_WorldStatic, ClimbQueryParams);
-
-#if 0
-	DrawDebugDirectionalArrow(GetWorld(), checkLocation, checkEnd, 4.f, FColor::Purple, true, -1.0f, 0U, 2.f);
-#endif
+	const FWorldClimbingCollision collision(*this, ClimbQueryParams, QueryStats, TEXT("LedgeClimbCheck"));
 
-	return IsWalkable(ledgeHit);
+	return ClimbingMath::CanMoveToLedgeClimbTarget(collision, target, capsule->GetScaledCapsuleRadius(), capsule->GetScaledCapsuleHalfHeight(),
+		capsule->GetUnscaledCapsuleHalfHeight());
 }
 
 void UMyCharacterMovementComponent::ComputeClimbingVelocity(float deltaTime)
@@ -358,7 +1016,7 @@ void UMyCharacterMovementComponent::ComputeClimbingVelocity(float deltaTime)
 		{
 			AlignClimbDashDirection();
 
-			const float currentCurveSpeed = ClimbDashCurve->GetFloatValue(CurrentClimbDashTime);
+			const float currentCurveSpeed = ClimbDashCurve.Get()->GetFloatValue(CurrentClimbDashTime);
 			Velocity = CurrentClimbingDirection * currentCurveSpeed;
 		}
 		else
@@ -382,13 +1040,12 @@ void UMyCharacterMovementComponent::AlignClimbDashDirection()
 
 void UMyCharacterMovementComponent::StopClimbDashing()
 {
-	// Dirty hack to fix the dash animations offset (not in place)
-#if 0
-	if (bIsClimbDashing && bIsClimbingLedge == false)
+#if ENABLE_VISUAL_LOG
+	// The dash animations aren't in place, record the offset they leave rather than correcting it here.
+	if (bIsClimbDashing && bIsClimbingLedge == false && FVisualLogger::IsRecording())
 	{
-		FHitResult hit(1.f);
-		constexpr bool sweep = true;
-		SafeMoveUpdatedComponent(CurrentClimbingDirection * 40.f, UpdatedComponent->GetComponentQuat(), sweep, hit);
+		const FVector location = UpdatedComponent->GetComponentLocation();
+		UE_VLOG_ARROW(CharacterOwner, LogClimbing, Log, location, location + CurrentClimbingDirection * 40.f, FColor::Purple, TEXT("Dash end offset"));
 	}
 #endif
 
@@ -433,7 +1090,7 @@ FQuat UMyCharacterMovementComponent::GetClimbingRotation(float deltaTime) const
 	}
 
 	const FQuat target = FRotationMatrix::MakeFromX(-CurrentClimbingNormal).ToQuat();
-	const float rotationSpeed = ClimbingRotationSpeed * FMath::Max(1, Velocity.Length() / MaxClimbingSpeed);
+	const float rotationSpeed = ClimbingMath::ScaleWithClimbingSpeed(ClimbingRotationSpeed, Velocity.Length(), MaxClimbingSpeed);
 
 	return FMath::QInterpTo(current, target, deltaTime, rotationSpeed);
 }
@@ -443,7 +1100,7 @@ bool UMyCharacterMovementComponent::TryClimbUpLedge()
 	if (bIsClimbingLedge)
 	{
 		// Finished climbing up the ledge, let's move the component (work around for animation root motion not working).
-		if (AnimInstance->Montage_IsPlaying(LedgeClimbMontage) == false)
+		if (AnimInstance->Montage_IsPlaying(LedgeClimbMontage.Get()) == false)
 		{
 			UpdatedComponent->SetWorldLocation(TargetLedgePosition);
 			bIsClimbingLedge = false;
@@ -455,51 +1112,220 @@ bool UMyCharacterMovementComponent::TryClimbUpLedge()
 	const float upAcceleration = FVector::DotProduct(CurrentClimbingDirection, UpdatedComponent->GetUpVector());
 	const bool isMovingUp = upAcceleration > 0.0f;
 
-	if (isMovingUp && HasReachedEdge() && CanMoveToLedgeClimbLocation())
+	if (isMovingUp && HasReachedEdge())
 	{
-		bIsClimbingLedge = true;
-		StopClimbDashing();
-
-		SetRotationToStand();
-		AnimInstance->Montage_Play(LedgeClimbMontage);
+		if (LedgeClimbMontage.IsValid() && CanMoveToLedgeClimbLocation())
+		{
+			StartClimbUpLedge();
+			return true;
+		}
 
-		return true;
+		// No room to stand on top of the ledge or its montage isn't loaded yet, hang on it instead.
+		TryStartShimmying();
 	}
 
 	return false;
 }
 
+void UMyCharacterMovementComponent::StartClimbUpLedge()
+{
+	bIsClimbingLedge = true;
+	StopClimbDashing();
+
+	SetRotationToStand();
+	AnimInstance->Montage_Play(LedgeClimbMontage.Get());
+}
+
 void UMyCharacterMovementComponent::StopClimbUpLedge()
 {
 	if (bIsClimbingLedge)
 	{
-		AnimInstance->Montage_Stop(0.f, LedgeClimbMontage);
+		AnimInstance->Montage_Stop(0.f, LedgeClimbMontage.Get());
 		TargetLedgePosition = FVector::ZeroVector;
 		bIsClimbingLedge = false;
 	}
 }
 
+bool UMyCharacterMovementComponent::TryStartShimmying()
+{
+	const FVector horizontalNormal = CurrentClimbingNormal.GetSafeNormal2D();
+	if (horizontalNormal.IsZero())
+	{
+		return false;
+	}
+
+	const FVector location = UpdatedComponent->GetComponentLocation();
+	const float ledgeSearchHeight = CharacterOwner->BaseEyeHeight + ClimbingCollisionShrinkAmount + LedgeEyeHeightOffset;
+
+	// Look down for the top of the ledge, from above it (where HasReachedEdge found nothing) to the character's location.
+	const FVector wallPoint = FVector(CurrentClimbingPosition.X, CurrentClimbingPosition.Y, location.Z) - horizontalNormal * LedgeProbeDepth;
+	const FVector start = wallPoint + FVector::UpVector * ledgeSearchHeight;
+
+	FHitResult ledgeHit;
+	++QueryStats.NumQueries;
+	const uint64 startCycles = BeginClimbingProbe();
+	const bool foundLedge = GetWorld()->LineTraceSingleByChannel(ledgeHit, start, wallPoint, ECC_WorldStatic, ClimbQueryParams);
+
+	VLogClimbingProbe(CharacterOwner, TEXT("LedgeTrace"), start, wallPoint, FCollisionShape(), foundLedge ? 1 : 0, startCycles);
+
+	if (foundLedge == false || ledgeHit.bStartPenetrating)
+	{
+		return false;
+	}
+
+	LedgeNormal = horizontalNormal;
+	LedgeDirection = FVector::CrossProduct(LedgeNormal, FVector::UpVector);
+	LedgeEdgePosition = FVector(CurrentClimbingPosition.X, CurrentClimbingPosition.Y, ledgeHit.ImpactPoint.Z);
+	LedgeHangHeight = location.Z - LedgeEdgePosition.Z;
+	LedgeDistance = 0.f;
+
+	SetClimbingBase(ledgeHit.GetComponent());
+
+	StopClimbDashing();
+	SetMovementMode(EMovementMode::MOVE_Custom, ECustomMovementMode::CMOVE_Shimmying);
+
+	return true;
+}
+
+void UMyCharacterMovementComponent::PhysShimmying(float deltaTime, int32 iterations)
+{
+	if (deltaTime < MIN_TICK_TIME)
+	{
+		return;
+	}
+
+	ApplyClimbingBaseMovement();
+
+	if (bIsClimbingLedge)
+	{
+		TryClimbUpLedge();
+
+		if (bIsClimbingLedge == false)
+		{
+			StopClimbing(deltaTime, iterations);
+		}
+
+		return;
+	}
+
+	if (bWantsToClimb == false)
+	{
+		StopClimbing(deltaTime, iterations);
+		return;
+	}
+
+	const FVector inputDirection = Acceleration.GetSafeNormal();
+	const float upInput = FVector::DotProduct(inputDirection, FVector::UpVector);
+	const float sideInput = FVector::DotProduct(inputDirection, LedgeDirection);
+
+	if (-upInput > FMath::Abs(sideInput))
+	{
+		StopShimmying(deltaTime, iterations);
+		return;
+	}
+
+	if (upInput > FMath::Abs(sideInput) && LedgeClimbMontage.IsValid() && CanMoveToLedgeClimbLocation())
+	{
+		StartClimbUpLedge();
+		return;
+	}
+
+	// A single probe on the cached ledge tells whether it continues, the surface is never swept.
+	// It looks ahead when moving, and under the hands when hanging still or when the ledge ends ahead.
+	const float targetDistance = LedgeDistance + sideInput * MaxShimmySpeed * deltaTime;
+	const bool isMovingAlongLedge = FMath::IsNearlyEqual(targetDistance, LedgeDistance) == false;
+
+	if (isMovingAlongLedge && IsLedgeContinuous(targetDistance))
+	{
+		LedgeDistance = targetDistance;
+	}
+	else if (IsLedgeContinuous(LedgeDistance) == false)
+	{
+		StopClimbing(deltaTime, iterations);
+		return;
+	}
+
+	CurrentClimbingNormal = LedgeNormal;
+	CurrentClimbingDirection = LedgeDirection * FMath::Sign(sideInput);
+
+	const FVector oldLocation = UpdatedComponent->GetComponentLocation();
+	const FVector adjusted = GetLedgeHangLocation(LedgeDistance) - oldLocation;
+
+	const FQuat target = FRotationMatrix::MakeFromX(-LedgeNormal).ToQuat();
+	const FQuat rotation = FMath::QInterpTo(UpdatedComponent->GetComponentQuat(), target, deltaTime, ClimbingRotationSpeed);
+
+	FHitResult hit(1.f);
+	constexpr bool sweep = true;
+
+	SafeMoveUpdatedComponent(adjusted, rotation, sweep, hit);
+
+	if (hit.Time < 1.f)
+	{
+		// Something is in the way along the ledge, resume from where the capsule stopped.
+		LedgeDistance = FVector::DotProduct(UpdatedComponent->GetComponentLocation() - LedgeEdgePosition, LedgeDirection);
+	}
+
+	if (HasAnimRootMotion() == false && CurrentRootMotion.HasOverrideVelocity() == false)
+	{
+		Velocity = (UpdatedComponent->GetComponentLocation() - oldLocation) / deltaTime;
+	}
+}
+
+void UMyCharacterMovementComponent::StopShimmying(float deltaTime, int32 iterations)
+{
+	SetMovementMode(EMovementMode::MOVE_Custom, ECustomMovementMode::CMOVE_Climbing);
+	StartNewPhysics(deltaTime, iterations);
+}
+
+bool UMyCharacterMovementComponent::IsLedgeContinuous(const float distance) const
+{
+	const FVector probePoint = LedgeEdgePosition + LedgeDirection * distance - LedgeNormal * LedgeProbeDepth;
+	const FVector start = probePoint + FVector::UpVector * LedgeHeightTolerance;
+	const FVector end = probePoint + FVector::DownVector * LedgeHeightTolerance;
+
+	FHitResult ledgeHit;
+	++QueryStats.NumQueries;
+	const uint64 startCycles = BeginClimbingProbe();
+	const bool foundLedge = GetWorld()->LineTraceSingleByChannel(ledgeHit, start, end, ECC_WorldStatic, ClimbQueryParams);
+
+	VLogClimbingProbe(CharacterOwner, TEXT("LedgeContinuityTrace"), start, end, FCollisionShape(), foundLedge ? 1 : 0, startCycles);
+
+	return foundLedge && ledgeHit.bStartPenetrating == false;
+}
+
+FVector UMyCharacterMovementComponent::GetLedgeHangLocation(const float distance) const
+{
+	return LedgeEdgePosition + LedgeDirection * distance + LedgeNormal * DistanceFromSurface + FVector::UpVector * LedgeHangHeight;
+}
+
 void UMyCharacterMovementComponent::SnapToClimbingSurface(float deltaTime) const
 {
 	const FVector forward = UpdatedComponent->GetForwardVector();
 	const FVector location = UpdatedComponent->GetComponentLocation();
 	const FQuat rotation = UpdatedComponent->GetComponentQuat();
 
-	const FVector forwardDifference = (CurrentClimbingPosition - location).ProjectOnTo(forward);
+	const ClimbingMath::FSurfaceInfo surface = { ToClimbingVec(CurrentClimbingPosition), ToClimbingVec(CurrentClimbingNormal) };
+	const float snapSpeed = ClimbingMath::ScaleWithClimbingSpeed(ClimbingSnapSpeed, Velocity.Length(), MaxClimbingSpeed);
 
-	const FVector offset = -CurrentClimbingNormal * (forwardDifference.Length() - DistanceFromSurface);
+	const FVector delta = ToFVector(ClimbingMath::ComputeSnapDelta(ToClimbingVec(location), ToClimbingVec(forward), surface,
+		DistanceFromSurface, snapSpeed, deltaTime));
 
 	constexpr bool sweep = true;
 
-	const float snapSpeed = ClimbingSnapSpeed * FMath::Max(1, Velocity.Length() / MaxClimbingSpeed);
-	UpdatedComponent->MoveComponent(offset * snapSpeed * deltaTime, rotation, sweep);
+	UpdatedComponent->MoveComponent(delta, rotation, sweep);
 }
 
 void UMyCharacterMovementComponent::TryClimbing()
 {
-	if (CanStartClimbing())
+	const bool canStartClimbing = HasValidClimbStartPrediction() || CanStartClimbing();
+
+	if (canStartClimbing)
 	{
 		bWantsToClimb = true;
+
+		// Evaluated again once the character is back off the wall.
+		bCanStartClimbingPrediction = false;
+		TimeSinceClimbStartPrediction = TNumericLimits<float>::Max();
 	}
 }
 
@@ -545,11 +1371,190 @@ FVector UMyCharacterMovementComponent::GetClimbingDirection() const
 	return CurrentClimbingDirection;
 }
 
+FVector UMyCharacterMovementComponent::GetClimbSurfacePosition() const
+{
+	return CurrentClimbingPosition;
+}
+
+FVector UMyCharacterMovementComponent::GetLedgeEdgePosition() const
+{
+	return LedgeEdgePosition;
+}
+
+FVector UMyCharacterMovementComponent::GetLedgeNormal() const
+{
+	return LedgeNormal;
+}
+
+const TArray<FHitResult>& UMyCharacterMovementComponent::GetClimbWallHits() const
+{
+	return CurrentWallHits;
+}
+
+const FClimbingQueryStats& UMyCharacterMovementComponent::GetClimbingQueryStats() const
+{
+	return QueryStats;
+}
+
+void UMyCharacterMovementComponent::ResetClimbingQueryStats()
+{
+	QueryStats = FClimbingQueryStats();
+}
+
+void UMyCharacterMovementComponent::SaveClimbingState(FClimbingStateSnapshot& outSnapshot) const
+{
+	// The cached climbing state is in sync with the base transform it was last carried to.
+	const UPrimitiveComponent* base = ClimbingBase.Get();
+	const FTransform& baseTransform = base != nullptr ? ClimbingBaseTransform : FTransform::Identity;
+
+	outSnapshot.ClimbingBase = FObjectKey(base);
+	outSnapshot.ClimbingBaseLocation = baseTransform.GetLocation();
+	outSnapshot.ClimbingBaseRotation = baseTransform.GetRotation();
+	outSnapshot.ClimbingBaseScale = baseTransform.GetScale3D();
+
+	const auto toBasePosition = [&](const FVector& position)
+	{
+		return baseTransform.InverseTransformPosition(position);
+	};
+
+	const auto toBaseDirection = [&](const FVector& direction)
+	{
+		return baseTransform.InverseTransformVectorNoScale(direction);
+	};
+
+	outSnapshot.Location = toBasePosition(UpdatedComponent->GetComponentLocation());
+	outSnapshot.Rotation = baseTransform.GetRotation().Inverse() * UpdatedComponent->GetComponentQuat();
+	outSnapshot.Velocity = toBaseDirection(Velocity);
+
+	outSnapshot.CurrentClimbingNormal = toBaseDirection(CurrentClimbingNormal);
+	outSnapshot.CurrentClimbingPosition = toBasePosition(CurrentClimbingPosition);
+	outSnapshot.CurrentClimbingDirection = toBaseDirection(CurrentClimbingDirection);
+	outSnapshot.TargetLedgePosition = TargetLedgePosition.IsZero() ? FVector::ZeroVector : toBasePosition(TargetLedgePosition);
+
+	outSnapshot.LedgeEdgePosition = toBasePosition(LedgeEdgePosition);
+	outSnapshot.LedgeDirection = toBaseDirection(LedgeDirection);
+	outSnapshot.LedgeNormal = toBaseDirection(LedgeNormal);
+	outSnapshot.LedgeHangHeight = LedgeHangHeight;
+	outSnapshot.LedgeDistance = LedgeDistance;
+
+	outSnapshot.CurrentClimbDashTime = CurrentClimbDashTime;
+	outSnapshot.TimeSinceClimbingProbes = TimeSinceClimbingProbes;
+	outSnapshot.TimeSinceClimbStartPrediction = TimeSinceClimbStartPrediction;
+	outSnapshot.ClimbingStepAccumulator = ClimbingStepAccumulator;
+	outSnapshot.CapsuleHalfHeight = CharacterOwner->GetCapsuleComponent()->GetUnscaledCapsuleHalfHeight();
+
+	outSnapshot.MovementMode = MovementMode;
+	outSnapshot.CustomMovementMode = CustomMovementMode;
+	outSnapshot.PreviousClimbingState = PreviousClimbingState;
+
+	outSnapshot.bWantsToClimb = bWantsToClimb;
+	outSnapshot.bCanStartClimbingPrediction = bCanStartClimbingPrediction;
+	outSnapshot.bIsClimbDashing = bIsClimbDashing;
+	outSnapshot.bIsClimbingLedge = bIsClimbingLedge;
+	outSnapshot.bOrientRotationToMovement = bOrientRotationToMovement;
+}
+
+void UMyCharacterMovementComponent::RestoreClimbingState(const FClimbingStateSnapshot& snapshot)
+{
+	const EMovementMode previousMovementMode = MovementMode;
+	const uint8 previousCustomMode = CustomMovementMode;
+
+	// The climbed base is followed from where it is now, not from where it was when the snapshot was taken.
+	UPrimitiveComponent* base = Cast<UPrimitiveComponent>(snapshot.ClimbingBase.ResolveObjectPtr());
+	const FTransform baseTransform = base != nullptr ? base->GetComponentTransform() :
+		FTransform(snapshot.ClimbingBaseRotation, snapshot.ClimbingBaseLocation, snapshot.ClimbingBaseScale);
+
+	const auto toWorldPosition = [&](const FVector& position)
+	{
+		return baseTransform.TransformPosition(position);
+	};
+
+	const auto toWorldDirection = [&](const FVector& direction)
+	{
+		return baseTransform.TransformVectorNoScale(direction);
+	};
+
+	CharacterOwner->GetCapsuleComponent()->SetCapsuleHalfHeight(snapshot.CapsuleHalfHeight);
+	UpdatedComponent->SetWorldLocationAndRotation(toWorldPosition(snapshot.Location), baseTransform.GetRotation() * snapshot.Rotation,
+		false, nullptr, ETeleportType::TeleportPhysics);
+	Velocity = toWorldDirection(snapshot.Velocity);
+
+	CurrentClimbingNormal = toWorldDirection(snapshot.CurrentClimbingNormal);
+	CurrentClimbingPosition = toWorldPosition(snapshot.CurrentClimbingPosition);
+	CurrentClimbingDirection = toWorldDirection(snapshot.CurrentClimbingDirection);
+	TargetLedgePosition = snapshot.TargetLedgePosition.IsZero() ? FVector::ZeroVector : toWorldPosition(snapshot.TargetLedgePosition);
+
+	LedgeEdgePosition = toWorldPosition(snapshot.LedgeEdgePosition);
+	LedgeDirection = toWorldDirection(snapshot.LedgeDirection);
+	LedgeNormal = toWorldDirection(snapshot.LedgeNormal);
+	LedgeHangHeight = snapshot.LedgeHangHeight;
+	LedgeDistance = snapshot.LedgeDistance;
+
+	CurrentClimbDashTime = snapshot.CurrentClimbDashTime;
+	TimeSinceClimbingProbes = snapshot.TimeSinceClimbingProbes;
+	TimeSinceClimbStartPrediction = snapshot.TimeSinceClimbStartPrediction;
+
+	// A restore is a teleport, the mesh stops interpolating from wherever it was presented.
+	ResetClimbingStepPresentation();
+	ClimbingStepAccumulator = snapshot.ClimbingStepAccumulator;
+
+	// Modes are assigned directly, going through SetMovementMode would resize the capsule and stop the character.
+	MovementMode = (EMovementMode)snapshot.MovementMode;
+	CustomMovementMode = snapshot.CustomMovementMode;
+	PreviousClimbingState = snapshot.PreviousClimbingState;
+
+	bWantsToClimb = snapshot.bWantsToClimb;
+	bCanStartClimbingPrediction = snapshot.bCanStartClimbingPrediction;
+	bIsClimbDashing = snapshot.bIsClimbDashing;
+	bIsClimbingLedge = snapshot.bIsClimbingLedge;
+	bOrientRotationToMovement = snapshot.bOrientRotationToMovement;
+
+	// The wall hits only depend on the restored location and normal.
+	SweepAndStoreWallHits();
+
+	SetClimbingBase(IsClimbing() || IsShimmying() ? base : nullptr);
+
+	if (MovementMode == previousMovementMode && CustomMovementMode == previousCustomMode)
+	{
+		return;
+	}
+
+	// What SetMovementMode would have told the owner, so replication and mode change listeners see the restored mode.
+	if (CharacterOwner->HasAuthority())
+	{
+		CharacterOwner->ReplicatedMovementMode = PackNetworkMovementMode();
+	}
+
+	CharacterOwner->OnMovementModeChanged(previousMovementMode, previousCustomMode);
+}
+
+bool UMyCharacterMovementComponent::IsUsingFixedClimbingStep() const
+{
+	return bUseFixedClimbingStep;
+}
+
+void UMyCharacterMovementComponent::SetUseFixedClimbingStep(bool useFixedClimbingStep)
+{
+	bUseFixedClimbingStep = useFixedClimbingStep;
+
+	ResetClimbingStepPresentation();
+}
+
 bool UMyCharacterMovementComponent::IsClimbing() const
 {
 	return MovementMode == EMovementMode::MOVE_Custom && CustomMovementMode == ECustomMovementMode::CMOVE_Climbing;
 }
 
+bool UMyCharacterMovementComponent::IsShimmying() const
+{
+	return MovementMode == EMovementMode::MOVE_Custom && CustomMovementMode == ECustomMovementMode::CMOVE_Shimmying;
+}
+
+bool UMyCharacterMovementComponent::IsOnClimbingSurface() const
+{
+	return IsClimbing() || IsShimmying();
+}
+
 bool UMyCharacterMovementComponent::IsClimbDashing() const
 {
 	return IsClimbing() && bIsClimbDashing;
@@ -557,5 +1562,5 @@ bool UMyCharacterMovementComponent::IsClimbDashing() const
 
 bool UMyCharacterMovementComponent::IsClimbingLedge() const
 {
-	return IsClimbing() && bIsClimbingLedge;
+	return (IsClimbing() || IsShimmying()) && bIsClimbingLedge;
 }
\ No newline at end of file
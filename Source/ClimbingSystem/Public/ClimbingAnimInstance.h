@@ -0,0 +1,95 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "ClimbingLimbIKComponent.h"
+
+#include "ClimbingAnimInstance.generated.h"
+
+/**
+ * Climbing state snapshot taken once per frame on the game thread.
+ * The anim graph only reads these members, which lets its update run on worker threads.
+ */
+USTRUCT(BlueprintType)
+struct FClimbingAnimInstanceProxy : public FAnimInstanceProxy
+{
+	GENERATED_BODY()
+
+public:
+	FClimbingAnimInstanceProxy() = default;
+
+	FClimbingAnimInstanceProxy(UAnimInstance* animInstance)
+		: FAnimInstanceProxy(animInstance)
+	{
+	}
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Climbing")
+	bool bIsClimbing = false;
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Climbing")
+	bool bIsShimmying = false;
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Climbing")
+	bool bIsClimbDashing = false;
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Climbing")
+	bool bIsClimbingLedge = false;
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Climbing")
+	bool bIsFalling = false;
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Climbing")
+	FVector ClimbSurfaceNormal = FVector::ZeroVector;
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Climbing")
+	FVector ClimbingDirection = FVector::ZeroVector;
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Climbing")
+	FVector Velocity = FVector::ZeroVector;
+
+	/** Limb IK effectors, copied so the anim graph never calls into UClimbingLimbIKComponent. */
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Climbing")
+	FClimbingLimbPlacement HandLeftPlacement;
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Climbing")
+	FClimbingLimbPlacement HandRightPlacement;
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Climbing")
+	FClimbingLimbPlacement FootLeftPlacement;
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Climbing")
+	FClimbingLimbPlacement FootRightPlacement;
+
+	/** Derived on the worker thread from the snapshot above. */
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Climbing")
+	float GroundSpeed = 0.f;
+
+	/** Climbing velocity along the surface, to drive the climbing blend spaces. */
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Climbing")
+	float ClimbingRightSpeed = 0.f;
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Climbing")
+	float ClimbingUpSpeed = 0.f;
+
+protected:
+	virtual void PreUpdate(UAnimInstance* animInstance, float deltaSeconds) override;
+
+	virtual void Update(float deltaSeconds) override;
+};
+
+UCLASS(Transient, Blueprintable)
+class CLIMBINGSYSTEM_API UClimbingAnimInstance : public UAnimInstance
+{
+	GENERATED_BODY()
+
+private:
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Climbing", meta = (AllowPrivateAccess = "true"))
+	FClimbingAnimInstanceProxy Proxy;
+
+	virtual FAnimInstanceProxy* CreateAnimInstanceProxy() override;
+
+	virtual void DestroyAnimInstanceProxy(FAnimInstanceProxy* animInstanceProxy) override;
+
+	friend struct FClimbingAnimInstanceProxy;
+};
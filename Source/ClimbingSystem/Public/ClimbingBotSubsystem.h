@@ -0,0 +1,45 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+
+#include "ClimbingBotSubsystem.generated.h"
+
+class AClimbingSystemCharacter;
+
+/**
+ * With -ClimbingBot on a client, drives the local player's character through its own inputs: walks into walls, climbs,
+ * dashes and lets go on its own, to load a server with climbing clients. See AClimbingSystemGameMode for the measurement.
+ *
+ * Never created in shipping builds.
+ */
+UCLASS()
+class UClimbingBotSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* outer) const override;
+
+	virtual void Initialize(FSubsystemCollectionBase& collection) override;
+
+	// FTickableGameObject interface
+	virtual void Tick(float deltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+private:
+	AClimbingSystemCharacter* GetBotCharacter() const;
+
+	/** The bot just let go of a wall and doesn't climb again until its next action */
+	bool bHasLetGo = false;
+
+	float TimeToNextAction = 0.f;
+
+	FVector2D MoveValue = FVector2D::ZeroVector;
+
+	FRandomStream Random;
+};
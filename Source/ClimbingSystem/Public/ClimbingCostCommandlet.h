@@ -0,0 +1,91 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+
+#include "ClimbingCostCommandlet.generated.h"
+
+class ACharacter;
+struct FClimbingStateSnapshot;
+
+/**
+ * Runs a probe character on every climbable surface of a map and reports what climbing costs there.
+ *
+ * Usage: -run=ClimbingCost -Map=/Game/ClimbingSystem/Maps/TestClimbingLevel [-GridSpacing=150] [-ProbeDuration=3]
+ *        [-CharacterClass=/Game/ClimbingSystem/Blueprints/BP_ThirdPersonCharacter.BP_ThirdPersonCharacter_C] [-MaxProbes=2000]
+ *        [-VerifyRollback] [-CompareFixedStep] [-FrameRate=60]
+ *
+ * Writes a CSV of every probe and a top-down heatmap of the queries per frame to Saved/Profiling/ClimbingCost.
+ * With -VerifyRollback, each probe also replays its climb from a restored climbing snapshot and fails if it diverges.
+ * With -CompareFixedStep, each probe climbs both per frame and with fixed climbing steps, and reports their cost and how far apart they end up.
+ */
+UCLASS()
+class UClimbingCostCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UClimbingCostCommandlet();
+
+	virtual int32 Main(const FString& params) override;
+
+private:
+	struct FProbeStart
+	{
+		FVector Location;
+		FVector Normal;
+	};
+
+	struct FProbeResult
+	{
+		FProbeStart Start;
+		bool bStartedClimbing = false;
+		float QueriesPerFrame = 0.f;
+		float HitsPerSweep = 0.f;
+		float MillisecondsPerTick = 0.f;
+		float AverageNormalJitter = 0.f;
+		float MaxNormalJitter = 0.f;
+
+		/** Largest distance between a climb and its replay from a snapshot, negative when not verified. */
+		float RollbackDivergence = -1.f;
+
+		/** Climbing cost per frame when stepped per frame and with fixed steps, and the largest distance between both, negative when not compared. */
+		float FrameRateMillisecondsPerFrame = -1.f;
+		float FixedStepMillisecondsPerFrame = -1.f;
+		float FixedStepDivergence = -1.f;
+	};
+
+	float GridSpacing = 150.f;
+
+	float ProbeDuration = 3.f;
+
+	float ProbeStandOff = 60.f;
+
+	float FrameDeltaTime = 1.f / 60.f;
+
+	int32 MaxProbes = 2000;
+
+	bool bVerifyRollback = false;
+
+	bool bCompareFixedStep = false;
+
+	UWorld* LoadWorld(const FString& mapName) const;
+
+	TArray<FProbeStart> FindProbeStarts(UWorld* world) const;
+
+	FProbeResult RunProbe(UWorld* world, ACharacter* character, const FProbeStart& start) const;
+
+	void ApplyProbeInput(ACharacter* character, int32 frame, int32 numFrames) const;
+
+	float MeasureRollbackDivergence(UWorld* world, ACharacter* character, int32 numFrames) const;
+
+	void CompareFixedClimbingStep(UWorld* world, ACharacter* character, int32 numFrames, FProbeResult& result) const;
+
+	uint64 ClimbFromSnapshot(UWorld* world, ACharacter* character, const FClimbingStateSnapshot& snapshot, int32 numFrames, TArray<FVector>& outTrajectory) const;
+
+	void TickWorld(UWorld* world) const;
+
+	bool WriteCsv(const FString& filePath, const TArray<FProbeResult>& results) const;
+
+	bool WriteHeatmap(const FString& filePath, const TArray<FProbeResult>& results) const;
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+
+#include "ClimbingLimbIKComponent.generated.h"
+
+class UMyCharacterMovementComponent;
+
+UENUM(BlueprintType)
+enum class EClimbingLimb : uint8
+{
+	HandLeft,
+	HandRight,
+	FootLeft,
+	FootRight,
+	MAX			UMETA(Hidden),
+};
+
+USTRUCT(BlueprintType)
+struct FClimbingLimbPlacement
+{
+	GENERATED_BODY()
+
+	/** World space effector location for the limb IK. */
+	UPROPERTY(BlueprintReadOnly)
+	FVector Location = FVector::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly)
+	FVector Normal = FVector::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly)
+	float Alpha = 0.f;
+};
+
+/**
+ * Places hands and feet on the climbing surface for the animation IK.
+ * Limbs are projected onto the wall hits already swept by the movement component, no trace is issued per limb.
+ */
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class CLIMBINGSYSTEM_API UClimbingLimbIKComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UClimbingLimbIKComponent();
+
+	/** Game thread only, anim graphs read the copies in FClimbingAnimInstanceProxy. */
+	UFUNCTION(BlueprintPure)
+	FClimbingLimbPlacement GetLimbPlacement(EClimbingLimb limb) const;
+
+private:
+	UPROPERTY(Category = "Climbing IK", EditAnywhere)
+	FName HandLeftBoneName = TEXT("hand_l");
+
+	UPROPERTY(Category = "Climbing IK", EditAnywhere)
+	FName HandRightBoneName = TEXT("hand_r");
+
+	UPROPERTY(Category = "Climbing IK", EditAnywhere)
+	FName FootLeftBoneName = TEXT("foot_l");
+
+	UPROPERTY(Category = "Climbing IK", EditAnywhere)
+	FName FootRightBoneName = TEXT("foot_r");
+
+	/** Distance kept between the limb bone and the surface. */
+	UPROPERTY(Category = "Climbing IK", EditAnywhere, meta = (ClampMin = "0.0", ClampMax = "30.0"))
+	float LimbSurfaceOffset = 8.f;
+
+	/** Limbs further than this from the surface they would be placed on are left to the animation. */
+	UPROPERTY(Category = "Climbing IK", EditAnywhere, meta = (ClampMin = "1.0", ClampMax = "100.0"))
+	float MaxLimbReach = 40.f;
+
+	UPROPERTY(Category = "Climbing IK", EditAnywhere, meta = (ClampMin = "0.0", ClampMax = "60.0"))
+	float PlacementInterpSpeed = 15.f;
+
+	/** Characters further than this from the viewer update their placements at FarUpdateInterval. */
+	UPROPERTY(Category = "Climbing IK", EditAnywhere, meta = (ClampMin = "0.0"))
+	float NearViewDistance = 1500.f;
+
+	UPROPERTY(Category = "Climbing IK", EditAnywhere, meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float FarUpdateInterval = 0.2f;
+
+	UPROPERTY()
+	UMyCharacterMovementComponent* MovementComponent;
+
+	UPROPERTY()
+	USkeletalMeshComponent* Mesh;
+
+	FClimbingLimbPlacement TargetPlacements[(uint8)EClimbingLimb::MAX];
+
+	FClimbingLimbPlacement CurrentPlacements[(uint8)EClimbingLimb::MAX];
+
+	float TimeSinceLastUpdate = 0.f;
+
+private:
+	virtual void BeginPlay() override;
+
+	virtual void TickComponent(float deltaTime, ELevelTick tickType, FActorComponentTickFunction* thisTickFunction) override;
+
+	float GetUpdateInterval() const;
+
+	FName GetLimbBoneName(EClimbingLimb limb) const;
+
+	void UpdateTargetPlacements();
+
+	void InterpolatePlacements(float deltaTime);
+};
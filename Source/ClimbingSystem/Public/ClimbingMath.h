@@ -0,0 +1,351 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * Geometry of the climbing movement, free of any engine type so it can be built and measured on its own.
+ * World queries go through ICollisionQuery, UMyCharacterMovementComponent adapts it to its UWorld.
+ */
+namespace ClimbingMath
+{
+	struct FVec3
+	{
+		double X = 0.;
+		double Y = 0.;
+		double Z = 0.;
+
+		constexpr FVec3() = default;
+
+		constexpr FVec3(double x, double y, double z)
+			: X(x), Y(y), Z(z)
+		{
+		}
+
+		constexpr FVec3 operator+(const FVec3& other) const { return FVec3(X + other.X, Y + other.Y, Z + other.Z); }
+		constexpr FVec3 operator-(const FVec3& other) const { return FVec3(X - other.X, Y - other.Y, Z - other.Z); }
+		constexpr FVec3 operator-() const { return FVec3(-X, -Y, -Z); }
+		constexpr FVec3 operator*(double scale) const { return FVec3(X * scale, Y * scale, Z * scale); }
+		constexpr FVec3 operator/(double scale) const { return FVec3(X / scale, Y / scale, Z / scale); }
+
+		FVec3& operator+=(const FVec3& other)
+		{
+			X += other.X;
+			Y += other.Y;
+			Z += other.Z;
+			return *this;
+		}
+	};
+
+	constexpr double SmallNumber = 1.e-8;
+
+	constexpr double KindaSmallNumber = 1.e-4;
+
+	constexpr double Dot(const FVec3& a, const FVec3& b)
+	{
+		return a.X * b.X + a.Y * b.Y + a.Z * b.Z;
+	}
+
+	inline double Length(const FVec3& v)
+	{
+		return std::sqrt(Dot(v, v));
+	}
+
+	inline bool IsZero(const FVec3& v)
+	{
+		return v.X == 0. && v.Y == 0. && v.Z == 0.;
+	}
+
+	/** Same contract as FVector::GetSafeNormal, a zero vector when too small to be normalized. */
+	inline FVec3 GetSafeNormal(const FVec3& v, double tolerance = SmallNumber)
+	{
+		const double squareSum = Dot(v, v);
+
+		if (squareSum == 1.)
+		{
+			return v;
+		}
+
+		if (squareSum < tolerance)
+		{
+			return FVec3();
+		}
+
+		return v / std::sqrt(squareSum);
+	}
+
+	inline FVec3 GetSafeNormal2D(const FVec3& v, double tolerance = SmallNumber)
+	{
+		return GetSafeNormal(FVec3(v.X, v.Y, 0.), tolerance);
+	}
+
+	constexpr FVec3 ProjectOnTo(const FVec3& v, const FVec3& target)
+	{
+		return target * (Dot(v, target) / Dot(target, target));
+	}
+
+	struct FHit
+	{
+		/** Center of the swept shape when it hit, the impact point for line traces. */
+		FVec3 Location;
+		FVec3 Normal;
+
+		/** Whether the character could stand on what was hit, as its movement judges it. */
+		bool bWalkable = false;
+	};
+
+	/** The world as the climbing math sees it. */
+	class ICollisionQuery
+	{
+	public:
+		virtual ~ICollisionQuery() = default;
+
+		/** Fills outHit only when something blocks the trace. */
+		virtual bool LineTrace(const FVec3& start, const FVec3& end, FHit& outHit) const = 0;
+
+		/** Fills outHit only when something blocks the sweep. */
+		virtual bool SweepSphere(const FVec3& start, const FVec3& end, double radius, FHit& outHit) const = 0;
+
+		/** Sweeps an upright capsule, fills outHit only when something blocks the sweep. */
+		virtual bool SweepCapsule(const FVec3& start, const FVec3& end, double radius, double halfHeight, FHit& outHit) const = 0;
+	};
+
+	struct FSurfaceInfo
+	{
+		FVec3 Position;
+		FVec3 Normal;
+	};
+
+	struct FStartClimbingCheck
+	{
+		bool bCanStart = false;
+
+		/** How vertical the surface is, 1 for a wall. */
+		double Steepness = 0.;
+	};
+
+	struct FLedgeClimbTarget
+	{
+		FVec3 Position;
+		FVec3 HorizontalOffset;
+	};
+
+	/** Whether a surface hit is oriented so the character can start climbing it, before any trace. */
+	inline FStartClimbingCheck CheckStartClimbingSurface(const FVec3& forward, const FVec3& hitNormal, double maxHorizontalDegrees)
+	{
+		const FVec3 horizontalNormal = GetSafeNormal2D(hitNormal);
+
+		const double horizontalDot = Dot(forward, -horizontalNormal);
+		const double verticalDot = Dot(hitNormal, horizontalNormal);
+
+		const double horizontalDegrees = std::acos(horizontalDot) * (180. / 3.14159265358979323846);
+		const bool isCeiling = std::abs(verticalDot) <= SmallNumber;
+
+		FStartClimbingCheck check;
+		check.bCanStart = horizontalDegrees <= maxHorizontalDegrees && isCeiling == false;
+		check.Steepness = verticalDot;
+
+		return check;
+	}
+
+	/** The steeper the surface, the further it may be from the eyes when facing it. */
+	constexpr double GetFacingSurfaceTraceLength(double steepness)
+	{
+		constexpr double baseLength = 80.;
+		return baseLength * (1. + (1. - steepness) * 5.);
+	}
+
+	/** Whether a surface is in front of the eyes, close enough for its steepness. */
+	inline bool IsFacingSurface(const ICollisionQuery& collision, const FVec3& eyeLocation, const FVec3& forward, double steepness)
+	{
+		FHit surfaceHit;
+		return collision.LineTrace(eyeLocation, eyeLocation + forward * GetFacingSurfaceTraceLength(steepness), surfaceHit);
+	}
+
+	/** Whether any of the wall hits in front of the character can be climbed from where it stands. */
+	inline bool CanStartClimbing(const ICollisionQuery& collision, const FVec3& eyeLocation, const FVec3& forward,
+		const FHit* wallHits, int numWallHits, double maxHorizontalDegrees)
+	{
+		for (int hitIndex = 0; hitIndex < numWallHits; ++hitIndex)
+		{
+			const FHit& wallHit = wallHits[hitIndex];
+			const FStartClimbingCheck check = CheckStartClimbingSurface(forward, wallHit.Normal, maxHorizontalDegrees);
+
+			if (check.bCanStart && wallHit.bWalkable == false && IsFacingSurface(collision, eyeLocation, forward, check.Steepness))
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/** The top of the climbed surface is reached when nothing but a walkable surface is in front of the eyes. */
+	inline bool HasReachedEdge(const ICollisionQuery& collision, const FVec3& eyeLocation, const FVec3& forward, double traceDistance)
+	{
+		FHit surfaceHit;
+		return collision.LineTrace(eyeLocation, eyeLocation + forward * traceDistance, surfaceHit) == false || surfaceHit.bWalkable;
+	}
+
+	/** Whether there is walkable ground under a capsule standing at this location. */
+	inline bool IsLocationWalkable(const ICollisionQuery& collision, const FVec3& location, double capsuleHalfHeight)
+	{
+		FHit groundHit;
+		return collision.LineTrace(location, location - FVec3(0., 0., capsuleHalfHeight * 1.5), groundHit) && groundHit.bWalkable;
+	}
+
+	/**
+	 * Averages what small sphere sweeps towards each wall hit find, from the character's location.
+	 * Misses contribute a zero sample, like the engine hit results they replace.
+	 */
+	inline FSurfaceInfo ComputeSurfaceInfo(const ICollisionQuery& collision, const FVec3& start, const FVec3* wallImpactPoints, int numWallHits,
+		double sweepRadius = 6., double sweepDistance = 120.)
+	{
+		FSurfaceInfo surface;
+
+		if (numWallHits <= 0)
+		{
+			return surface;
+		}
+
+		for (int hitIndex = 0; hitIndex < numWallHits; ++hitIndex)
+		{
+			const FVec3 end = start + GetSafeNormal(wallImpactPoints[hitIndex] - start) * sweepDistance;
+
+			FHit assistHit;
+			collision.SweepSphere(start, end, sweepRadius, assistHit);
+
+			surface.Position += assistHit.Location;
+			surface.Normal += assistHit.Normal;
+		}
+
+		surface.Position = surface.Position / numWallHits;
+		surface.Normal = GetSafeNormal(surface.Normal);
+
+		return surface;
+	}
+
+	/** Where the character stands once it climbed up the ledge it is facing. */
+	inline FLedgeClimbTarget ComputeLedgeClimbTarget(const FVec3& location, const FVec3& forward, double upZ,
+		double capsuleRadius, double capsuleHalfHeight, double eyeHeightOffset, double distanceFromSurface)
+	{
+		// take steepness into account, the eyes will be closer to the ledge on a ramp than a wall as the collider is rotated
+		// the more forwardZAxis tends towards 0 (facing a wall), the more we need to adjust horizontally based on the capsule radius
+		const double wallDistance = (1. - std::abs(forward.Z)) * (capsuleRadius * 2 + distanceFromSurface);
+		// the more forwardZAxis tends towards -1, the more we need to adjust horizontally based on the capsule height (to compensate for the steepness)
+		const double steepCorrection = -forward.Z * (capsuleHalfHeight + eyeHeightOffset) * (forward.Z <= 0. ? 1. : 0.25);
+		const double distanceToClimbLedge = wallDistance + steepCorrection;
+
+		FLedgeClimbTarget target;
+		target.HorizontalOffset = FVec3(forward.X * distanceToClimbLedge, forward.Y * distanceToClimbLedge, 0.);
+
+		const FVec3 verticalOffset(0., 0., capsuleHalfHeight + eyeHeightOffset * upZ);
+		target.Position = location + target.HorizontalOffset + verticalOffset;
+
+		return target;
+	}
+
+	/**
+	 * Whether the capsule fits on the ledge target, moving onto it horizontally from over the ledge.
+	 * walkableTraceHalfHeight sets how far below the target the ground is looked for, the movement component passes its unscaled capsule's.
+	 */
+	inline bool CanMoveToLedgeClimbTarget(const ICollisionQuery& collision, const FLedgeClimbTarget& target,
+		double capsuleRadius, double capsuleHalfHeight, double walkableTraceHalfHeight)
+	{
+		if (IsLocationWalkable(collision, target.Position, walkableTraceHalfHeight) == false)
+		{
+			return false;
+		}
+
+		FHit capsuleHit;
+		const bool isBlocked = collision.SweepCapsule(target.Position - target.HorizontalOffset, target.Position,
+			capsuleRadius, capsuleHalfHeight, capsuleHit);
+
+		return isBlocked == false || capsuleHit.bWalkable;
+	}
+
+	/** Speeds scaled up when moving faster than the climbing speed, so snapping and rotating keep up. */
+	inline double ScaleWithClimbingSpeed(double baseSpeed, double speed, double maxClimbingSpeed)
+	{
+		return baseSpeed * std::max(1., speed / maxClimbingSpeed);
+	}
+
+	/** Displacement bringing the character back to its distance from the surface. */
+	inline FVec3 ComputeSnapDelta(const FVec3& location, const FVec3& forward, const FSurfaceInfo& surface,
+		double distanceFromSurface, double snapSpeed, double deltaTime)
+	{
+		const FVec3 forwardDifference = ProjectOnTo(surface.Position - location, forward);
+		const FVec3 offset = -surface.Normal * (Length(forwardDifference) - distanceFromSurface);
+
+		return offset * snapSpeed * deltaTime;
+	}
+
+	/** Many climbers' vectors as one array per component, so the batch loops below vectorize. */
+	struct FVec3Array
+	{
+		double* X;
+		double* Y;
+		double* Z;
+	};
+
+	struct FConstVec3Array
+	{
+		const double* X;
+		const double* Y;
+		const double* Z;
+	};
+
+	/** CheckStartClimbingSurface for many climbers, branchless: the angle limit is compared as a cosine. */
+	inline void CheckStartClimbingSurfaces(int count, const FConstVec3Array& forwards, const FConstVec3Array& hitNormals,
+		double maxHorizontalDegrees, bool* outCanStart, double* outSteepness)
+	{
+		const double minHorizontalDot = std::cos(maxHorizontalDegrees * (3.14159265358979323846 / 180.));
+
+		for (int index = 0; index < count; ++index)
+		{
+			const double normalX = hitNormals.X[index];
+			const double normalY = hitNormals.Y[index];
+			const double horizontalSquareSum = normalX * normalX + normalY * normalY;
+
+			// Same tolerance as GetSafeNormal2D, a ceiling has no horizontal normal.
+			const double horizontalScale = horizontalSquareSum < SmallNumber ? 0. : 1. / std::sqrt(horizontalSquareSum);
+
+			const double horizontalDot = -(forwards.X[index] * normalX + forwards.Y[index] * normalY) * horizontalScale;
+			const double verticalDot = horizontalSquareSum * horizontalScale;
+
+			// acos is undefined past 1, which the scalar version rejects as well.
+			outCanStart[index] = horizontalDot >= minHorizontalDot && horizontalDot <= 1. && std::abs(verticalDot) > SmallNumber;
+			outSteepness[index] = verticalDot;
+		}
+	}
+
+	/** ComputeSnapDelta for many climbers. */
+	inline void ComputeSnapDeltas(int count, const FConstVec3Array& locations, const FConstVec3Array& forwards,
+		const FConstVec3Array& surfacePositions, const FConstVec3Array& surfaceNormals,
+		double distanceFromSurface, double snapSpeed, double deltaTime, const FVec3Array& outDeltas)
+	{
+		const double snapScale = snapSpeed * deltaTime;
+
+		for (int index = 0; index < count; ++index)
+		{
+			const double forwardX = forwards.X[index];
+			const double forwardY = forwards.Y[index];
+			const double forwardZ = forwards.Z[index];
+
+			const double toSurfaceX = surfacePositions.X[index] - locations.X[index];
+			const double toSurfaceY = surfacePositions.Y[index] - locations.Y[index];
+			const double toSurfaceZ = surfacePositions.Z[index] - locations.Z[index];
+
+			// Length of the projection on the forward vector, as ProjectOnTo then Length.
+			const double forwardSquareSum = forwardX * forwardX + forwardY * forwardY + forwardZ * forwardZ;
+			const double projectionScale = (toSurfaceX * forwardX + toSurfaceY * forwardY + toSurfaceZ * forwardZ) / forwardSquareSum;
+			const double forwardDistance = std::abs(projectionScale) * std::sqrt(forwardSquareSum);
+
+			const double offset = -(forwardDistance - distanceFromSurface) * snapScale;
+
+			outDeltas.X[index] = surfaceNormals.X[index] * offset;
+			outDeltas.Y[index] = surfaceNormals.Y[index] * offset;
+			outDeltas.Z[index] = surfaceNormals.Z[index] * offset;
+		}
+	}
+}
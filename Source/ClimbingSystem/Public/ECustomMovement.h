@@ -6,5 +6,6 @@ UENUM(BlueprintType)
 enum ECustomMovementMode
 {
 	CMOVE_Climbing      UMETA(DisplayName = "Climbing"),
+	CMOVE_Shimmying     UMETA(DisplayName = "Shimmying"),
 	CMOVE_MAX			UMETA(Hidden),
 };
\ No newline at end of file
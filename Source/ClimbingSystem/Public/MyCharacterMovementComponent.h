@@ -1,10 +1,95 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Engine/StreamableManager.h"
 #include "GameFramework/CharacterMovementComponent.h"
+#include "UObject/ObjectKey.h"
+
+#include <type_traits>
 
 #include "MyCharacterMovementComponent.generated.h"
 
+/** Sub-states of the climbing movement mode, each of them runs its own set of probes. */
+enum class EClimbingState : uint8
+{
+	Idle,
+	Moving,
+	Dashing,
+	ClimbingLedge,
+	MAX,
+};
+
+/** Cost counters of the climbing movement, accumulated until reset by whoever reads them. */
+struct FClimbingQueryStats
+{
+	/** Traces and sweeps issued against the world. */
+	int32 NumQueries = 0;
+
+	int32 NumWallSweeps = 0;
+
+	/** Hits accumulated over all the wall sweeps. */
+	int32 NumWallHits = 0;
+
+	/** Custom movement physics updates and the time spent in them. */
+	int32 NumPhysTicks = 0;
+
+	uint64 PhysCycles = 0;
+
+	/** Queries issued and physics updates run by each climbing state. */
+	int32 NumStateQueries[(uint8)EClimbingState::MAX] = {};
+
+	int32 NumStateTicks[(uint8)EClimbingState::MAX] = {};
+};
+
+/**
+ * Everything the climbing movement needs to resume from a point in time, for rollback and resimulation.
+ * Plain data, buffers of snapshots are copied as raw memory. Wall hits are swept again on restore rather than stored,
+ * and a ledge climb restored mid-montage ends on the next update.
+ * When climbing a moving base, the transform, the velocity and the climbing positions and directions are relative to the base,
+ * so a restore puts the character back on the base wherever it moved since.
+ */
+struct FClimbingStateSnapshot
+{
+	/** Resolves to nothing when there was no base or it was destroyed since, the saved base transform is used then. */
+	FObjectKey ClimbingBase;
+	FVector ClimbingBaseLocation;
+	FQuat ClimbingBaseRotation;
+	FVector ClimbingBaseScale;
+
+	FVector Location;
+	FQuat Rotation;
+	FVector Velocity;
+
+	FVector CurrentClimbingNormal;
+	FVector CurrentClimbingPosition;
+	FVector CurrentClimbingDirection;
+	FVector TargetLedgePosition;
+
+	FVector LedgeEdgePosition;
+	FVector LedgeDirection;
+	FVector LedgeNormal;
+	float LedgeHangHeight;
+	float LedgeDistance;
+
+	float CurrentClimbDashTime;
+	float TimeSinceClimbingProbes;
+	float TimeSinceClimbStartPrediction;
+	float ClimbingStepAccumulator;
+	float CapsuleHalfHeight;
+
+	uint8 MovementMode;
+	uint8 CustomMovementMode;
+	EClimbingState PreviousClimbingState;
+
+	bool bWantsToClimb;
+	bool bCanStartClimbingPrediction;
+	bool bIsClimbDashing;
+	bool bIsClimbingLedge;
+	bool bOrientRotationToMovement;
+};
+
+static_assert(std::is_trivially_copyable_v<FClimbingStateSnapshot>, "Climbing snapshots must be copyable as raw memory");
+
 UCLASS()
 class CLIMBINGSYSTEM_API UMyCharacterMovementComponent : public UCharacterMovementComponent
 {
@@ -13,9 +98,19 @@ class CLIMBINGSYSTEM_API UMyCharacterMovementComponent : public UCharacterMoveme
 public:
 	UMyCharacterMovementComponent();
 
-	UFUNCTION(BlueprintPure)
+	/** In the climbing mode itself, not shimmying along a ledge. Blueprints use IsOnClimbingSurface instead. */
 	bool IsClimbing() const;
 
+	UFUNCTION(BlueprintPure)
+	bool IsShimmying() const;
+
+	/**
+	 * Climbing or shimmying. Blueprint calls to IsClimbing are redirected here by DefaultEngine.ini,
+	 * so animation blueprints keep their climbing states while hanging from a ledge.
+	 */
+	UFUNCTION(BlueprintPure)
+	bool IsOnClimbingSurface() const;
+
 	UFUNCTION(BlueprintPure)
 	bool IsClimbDashing() const;
 
@@ -28,6 +123,36 @@ public:
 	UFUNCTION(BlueprintPure)
 	FVector GetClimbingDirection() const;
 
+	UFUNCTION(BlueprintPure)
+	FVector GetClimbSurfacePosition() const;
+
+	/** What the climber is doing on the wall, only meaningful while climbing or shimmying. */
+	EClimbingState GetClimbingState() const;
+
+	/** Ledge followed while shimmying, its top edge on the wall face and the wall normal. */
+	FVector GetLedgeEdgePosition() const;
+
+	FVector GetLedgeNormal() const;
+
+	/** Surface hits swept this tick, shared with systems that would otherwise trace the wall themselves. */
+	const TArray<FHitResult>& GetClimbWallHits() const;
+
+	const FClimbingQueryStats& GetClimbingQueryStats() const;
+
+	void ResetClimbingQueryStats();
+
+	void SaveClimbingState(FClimbingStateSnapshot& outSnapshot) const;
+
+	/**
+	 * Resumes from a snapshot without going through SetMovementMode, the capsule and velocity come from the snapshot instead.
+	 * The owner is still told about a mode change, so the replicated movement mode and mode change events follow.
+	 */
+	void RestoreClimbingState(const FClimbingStateSnapshot& snapshot);
+
+	bool IsUsingFixedClimbingStep() const;
+
+	void SetUseFixedClimbingStep(bool useFixedClimbingStep);
+
 	UFUNCTION(BlueprintCallable)
 	void TryClimbing();
 
@@ -74,25 +199,87 @@ private:
 	UPROPERTY(Category = "Character Movement: Climbing", EditAnywhere, meta = (ClampMin = "0.0", ClampMax = "120.0"))
 	float LedgeEyeHeightOffset = 60.f;
 
+	UPROPERTY(Category = "Character Movement: Climbing", EditAnywhere, meta = (ClampMin = "10.0", ClampMax = "500.0"))
+	float MaxShimmySpeed = 90.f;
+
+	/** How far past the wall face the ledge probes look for the top of the ledge. */
+	UPROPERTY(Category = "Character Movement: Climbing", EditAnywhere, meta = (ClampMin = "1.0", ClampMax = "60.0"))
+	float LedgeProbeDepth = 15.f;
+
+	/** Height difference tolerated along a ledge before it is considered to end. */
+	UPROPERTY(Category = "Character Movement: Climbing", EditAnywhere, meta = (ClampMin = "1.0", ClampMax = "60.0"))
+	float LedgeHeightTolerance = 10.f;
+
+	/** Loaded asynchronously once the character gets near a climbable surface. */
 	UPROPERTY(Category = "Character Movement: Climbing", EditDefaultsOnly)
-	UAnimMontage* LedgeClimbMontage;
+	TSoftObjectPtr<UAnimMontage> LedgeClimbMontage;
 
+	/** Loaded asynchronously once the character gets near a climbable surface. */
 	UPROPERTY(Category = "Character Movement: Climbing", EditDefaultsOnly)
-	UCurveFloat* ClimbDashCurve;
+	TSoftObjectPtr<UCurveFloat> ClimbDashCurve;
+
+	/** Time spent away from any climbable surface before the climbing assets are released. */
+	UPROPERTY(Category = "Character Movement: Climbing", EditAnywhere, meta = (ClampMin = "0.0"))
+	float ClimbingAssetsReleaseDelay = 30.f;
+
+	/** How long a climb start evaluated ahead of the climb input stays valid, it is refreshed twice as often near a wall. */
+	UPROPERTY(Category = "Character Movement: Climbing", EditAnywhere, meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float ClimbStartPredictionValidity = 0.2f;
+
+	/**
+	 * Steps the climbing model at a fixed rate, independent of the frame rate, and interpolates the mesh in between.
+	 * For standalone games and authority-only simulation: the step phase isn't part of saved moves or corrections,
+	 * so a predicting client and the server step at different times. Corrections restart the client's steps.
+	 */
+	UPROPERTY(Category = "Character Movement: Climbing", EditAnywhere)
+	bool bUseFixedClimbingStep = false;
+
+	/**
+	 * Fixed climbing step in seconds. 0 follows the async physics step of the project's physics settings
+	 * when physics ticks asynchronously, and 1/60 otherwise.
+	 */
+	UPROPERTY(Category = "Character Movement: Climbing", EditAnywhere, meta = (ClampMin = "0.0", ClampMax = "0.1", EditCondition = "bUseFixedClimbingStep"))
+	float ClimbingFixedTimeStep = 1.f / 60.f;
+
+	/** Climbing steps run in a single frame at most, the time left over is dropped when the frame is too long. */
+	UPROPERTY(Category = "Character Movement: Climbing", EditAnywhere, meta = (ClampMin = "1", ClampMax = "16", EditCondition = "bUseFixedClimbingStep"))
+	int32 MaxClimbingStepsPerFrame = 4;
 
 	UPROPERTY()
 	UAnimInstance* AnimInstance;
 
 	TArray<FHitResult> CurrentWallHits;
 
+	TSharedPtr<FStreamableHandle> ClimbingAssetsHandle;
+
+	float TimeAwayFromClimbableSurface = 0.f;
+
 	FCollisionQueryParams ClimbQueryParams;
 
+	mutable FClimbingQueryStats QueryStats;
+
 	bool bWantsToClimb = false;
 
 	bool bIsClimbDashing = false;
 
 	bool bIsClimbingLedge = false;
 
+	EClimbingState PreviousClimbingState = EClimbingState::MAX;
+
+	float TimeSinceClimbingProbes = 0.f;
+
+	// Climb start evaluated while approaching a wall, so pressing climb doesn't trace when it already succeeded.
+	bool bCanStartClimbingPrediction = false;
+
+	float TimeSinceClimbStartPrediction = TNumericLimits<float>::Max();
+
+	// Fixed climbing steps: time not simulated yet, and the step before the last one for the mesh to interpolate from.
+	float ClimbingStepAccumulator = 0.f;
+
+	FVector PreviousClimbingStepLocation = FVector::ZeroVector;
+
+	FQuat PreviousClimbingStepRotation = FQuat::Identity;
+
 	float CurrentClimbDashTime = 0.f;
 
 	float ClimbDashDuration = 0.f;
@@ -105,12 +292,31 @@ private:
 
 	FVector TargetLedgePosition = FVector::ZeroVector;
 
+	// Ledge extracted once when starting to shimmy, movement is then a 1D distance along it.
+	FVector LedgeEdgePosition = FVector::ZeroVector;
+
+	FVector LedgeDirection = FVector::ZeroVector;
+
+	FVector LedgeNormal = FVector::ZeroVector;
+
+	float LedgeHangHeight = 0.f;
+
+	float LedgeDistance = 0.f;
+
+	// Climbed primitive when it can move, the cached climbing state is carried along with its transform.
+	// It ticks before this component, as a movement base would.
+	TWeakObjectPtr<UPrimitiveComponent> ClimbingBase;
+
+	FTransform ClimbingBaseTransform = FTransform::Identity;
+
 private:
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type endPlayReason) override;
+
 	virtual void TickComponent(float deltaTime, ELevelTick tickType, FActorComponentTickFunction* thisTickFunction) override;
 
-	virtual void OnMovementUpdated(float deltaTime, const FVector& oldLocation, const FVector& oldVelocity) override;
+	virtual void UpdateCharacterStateBeforeMovement(float deltaSeconds) override;
 
 	virtual void OnMovementModeChanged(EMovementMode previousMovementMode, uint8 previousCustomMode) override;
 
@@ -120,7 +326,13 @@ private:
 
 	virtual void PhysCustom(float deltaTime, int32 iterations) override;
 
-	bool EyeHeightTrace(FHitResult& outHit, const float traceDistance, const float heightOffset = 0.f) const;
+	virtual FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+
+	virtual void UpdateFromCompressedFlags(uint8 flags) override;
+
+	virtual void OnClientCorrectionReceived(FNetworkPredictionData_Client_Character& clientData, float timeStamp, FVector newLocation,
+		FVector newVelocity, UPrimitiveComponent* newBase, FName newBaseBoneName, bool hasBase, bool baseRelativePosition,
+		uint8 serverMovementMode) override;
 
 	bool ShouldStopClimbing() const;
 
@@ -130,22 +342,50 @@ private:
 
 	bool TryClimbUpLedge();
 
-	bool HasReachedEdge() const;
+	void StartClimbUpLedge();
+
+	FVector GetClimbingEyeLocation(const float heightOffset = 0.f) const;
 
-	bool IsLocationWalkable(const FVector& checkLocation) const;
+	bool HasReachedEdge() const;
 
 	bool CanMoveToLedgeClimbLocation();
 
 	bool CanStartClimbing();
 
-	bool IsFacingSurface(float steepness) const;
+	void UpdateClimbStartPrediction(float deltaTime);
+
+	bool HasValidClimbStartPrediction() const;
 
 	FQuat GetClimbingRotation(float deltaTime) const;
 
 	void UpdateClimbDashState(float deltaTime);
 
+	void PhysClimbingModes(float deltaTime, int32 iterations);
+
+	void PhysFixedClimbingSteps(float deltaTime, int32 iterations);
+
+	float GetClimbingFixedTimeStep() const;
+
+	bool ShouldPresentClimbingSteps() const;
+
+	void UpdateClimbingStepPresentation() const;
+
+	void ResetClimbingStepPresentation();
+
 	void PhysClimbing(float deltaTime, int32 iterations);
 
+	uint8 GetDueClimbingProbes(EClimbingState state, float deltaTime);
+
+	void PhysShimmying(float deltaTime, int32 iterations);
+
+	bool TryStartShimmying();
+
+	void StopShimmying(float deltaTime, int32 iterations);
+
+	bool IsLedgeContinuous(const float distance) const;
+
+	FVector GetLedgeHangLocation(const float distance) const;
+
 	void SetRotationToStand() const;
 
 	void StopClimbing(float deltaTime, int32 iterations);
@@ -167,4 +407,18 @@ private:
 	void ComputeSurfaceInfo();
 
 	void SweepAndStoreWallHits();
+
+	void SetClimbingBase(UPrimitiveComponent* base);
+
+	void ApplyClimbingBaseMovement();
+
+	void UpdateClimbingAssets(float deltaTime);
+
+	void RequestClimbingAssets();
+
+	void OnClimbingAssetsLoaded();
+
+	void ReleaseClimbingAssets();
+
+	friend class FSavedMove_Climbing;
 };
\ No newline at end of file
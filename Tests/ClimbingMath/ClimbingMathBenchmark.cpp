@@ -0,0 +1,198 @@
+#include "ClimbingMath.h"
+#include "MockCollision.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace ClimbingMath;
+
+namespace
+{
+	constexpr int NumClimbers = 1024;
+
+	/** Keeps results alive so the optimizer can't drop the work being timed. */
+	volatile double Sink = 0.;
+
+	template <typename FunctionType>
+	double MeasureNanosecondsPerClimber(int iterations, FunctionType&& function)
+	{
+		const auto start = std::chrono::steady_clock::now();
+
+		for (int iteration = 0; iteration < iterations; ++iteration)
+		{
+			function();
+		}
+
+		const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count() / (static_cast<double>(iterations) * NumClimbers);
+	}
+
+	struct FClimbers
+	{
+		std::vector<double> Locations[3];
+		std::vector<double> Forwards[3];
+		std::vector<double> SurfacePositions[3];
+		std::vector<double> SurfaceNormals[3];
+
+		explicit FClimbers(int count)
+		{
+			std::mt19937 random(1);
+			std::uniform_real_distribution<double> coordinate(-500., 500.);
+			std::uniform_real_distribution<double> angle(-0.5, 0.5);
+
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				Locations[axis].resize(count);
+				Forwards[axis].resize(count);
+				SurfacePositions[axis].resize(count);
+				SurfaceNormals[axis].resize(count);
+			}
+
+			// Climbers roughly facing the walls they are on, as in game.
+			for (int index = 0; index < count; ++index)
+			{
+				const FVec3 location(coordinate(random), coordinate(random), coordinate(random));
+				const FVec3 normal = GetSafeNormal(FVec3(-1., angle(random), angle(random)));
+				const FVec3 forward = GetSafeNormal(-normal + FVec3(0., angle(random), angle(random)) * 0.2);
+				const FVec3 surfacePosition = location + forward * 50.;
+
+				Set(Locations, index, location);
+				Set(Forwards, index, forward);
+				Set(SurfacePositions, index, surfacePosition);
+				Set(SurfaceNormals, index, normal);
+			}
+		}
+
+		static void Set(std::vector<double> (&components)[3], int index, const FVec3& value)
+		{
+			components[0][index] = value.X;
+			components[1][index] = value.Y;
+			components[2][index] = value.Z;
+		}
+
+		static FVec3 Get(const std::vector<double> (&components)[3], int index)
+		{
+			return FVec3(components[0][index], components[1][index], components[2][index]);
+		}
+
+		static FConstVec3Array View(const std::vector<double> (&components)[3])
+		{
+			return { components[0].data(), components[1].data(), components[2].data() };
+		}
+	};
+}
+
+int main(int argc, char** argv)
+{
+	int iterations = 2000;
+
+	for (int argIndex = 1; argIndex + 1 < argc; ++argIndex)
+	{
+		if (std::strcmp(argv[argIndex], "--iterations") == 0)
+		{
+			iterations = std::atoi(argv[argIndex + 1]);
+		}
+	}
+
+	if (iterations <= 0)
+	{
+		std::fprintf(stderr, "--iterations must be positive\n");
+		return 1;
+	}
+
+	const FClimbers climbers(NumClimbers);
+
+	constexpr double maxHorizontalDegrees = 25.;
+	constexpr double distanceFromSurface = 45.;
+	constexpr double snapSpeed = 4.;
+	constexpr double deltaTime = 1. / 60.;
+
+	const std::unique_ptr<bool[]> canStart = std::make_unique<bool[]>(NumClimbers);
+	std::vector<double> steepness(NumClimbers);
+	std::vector<double> deltas[3] = { std::vector<double>(NumClimbers), std::vector<double>(NumClimbers), std::vector<double>(NumClimbers) };
+
+	const double scalarStartCheck = MeasureNanosecondsPerClimber(iterations, [&]()
+	{
+		double steepnessSum = 0.;
+		for (int index = 0; index < NumClimbers; ++index)
+		{
+			const FStartClimbingCheck check = CheckStartClimbingSurface(FClimbers::Get(climbers.Forwards, index),
+				FClimbers::Get(climbers.SurfaceNormals, index), maxHorizontalDegrees);
+			steepnessSum += check.bCanStart ? check.Steepness : 0.;
+		}
+		Sink = Sink + steepnessSum;
+	});
+
+	const double batchedStartCheck = MeasureNanosecondsPerClimber(iterations, [&]()
+	{
+		CheckStartClimbingSurfaces(NumClimbers, FClimbers::View(climbers.Forwards), FClimbers::View(climbers.SurfaceNormals),
+			maxHorizontalDegrees, canStart.get(), steepness.data());
+		Sink = Sink + steepness[NumClimbers - 1];
+	});
+
+	const double scalarSnap = MeasureNanosecondsPerClimber(iterations, [&]()
+	{
+		FVec3 deltaSum;
+		for (int index = 0; index < NumClimbers; ++index)
+		{
+			FSurfaceInfo surface;
+			surface.Position = FClimbers::Get(climbers.SurfacePositions, index);
+			surface.Normal = FClimbers::Get(climbers.SurfaceNormals, index);
+
+			deltaSum += ComputeSnapDelta(FClimbers::Get(climbers.Locations, index), FClimbers::Get(climbers.Forwards, index), surface,
+				distanceFromSurface, snapSpeed, deltaTime);
+		}
+		Sink = Sink + deltaSum.X;
+	});
+
+	const double batchedSnap = MeasureNanosecondsPerClimber(iterations, [&]()
+	{
+		ComputeSnapDeltas(NumClimbers, FClimbers::View(climbers.Locations), FClimbers::View(climbers.Forwards),
+			FClimbers::View(climbers.SurfacePositions), FClimbers::View(climbers.SurfaceNormals),
+			distanceFromSurface, snapSpeed, deltaTime, { deltas[0].data(), deltas[1].data(), deltas[2].data() });
+		Sink = Sink + deltas[0][NumClimbers - 1];
+	});
+
+	// The queries themselves dominate in game, these only show the kernel's own overhead around them.
+	FMockCollision world;
+	world.AddBox(FVec3(-1000., -1000., -10.), FVec3(1000., 1000., 0.));
+	world.AddBox(FVec3(100., -500., 0.), FVec3(200., 500., 200.));
+
+	const FVec3 wallPoints[] = { { 100., -20., 80. }, { 100., 20., 80. }, { 100., -20., 120. }, { 100., 20., 120. } };
+	FHit wallHit;
+	wallHit.Location = FVec3(100., 0., 100.);
+	wallHit.Normal = FVec3(-1., 0., 0.);
+
+	const double surfaceInfo = MeasureNanosecondsPerClimber(iterations, [&]()
+	{
+		for (int index = 0; index < NumClimbers; ++index)
+		{
+			Sink = Sink + ComputeSurfaceInfo(world, FVec3(0., 0., 100.), wallPoints, 4).Position.X;
+		}
+	});
+
+	const double canStartClimbing = MeasureNanosecondsPerClimber(iterations, [&]()
+	{
+		int numCanStart = 0;
+		for (int index = 0; index < NumClimbers; ++index)
+		{
+			numCanStart += CanStartClimbing(world, FVec3(40., 0., 150.), FVec3(1., 0., 0.), &wallHit, 1, maxHorizontalDegrees) ? 1 : 0;
+		}
+		Sink = Sink + numCanStart;
+	});
+
+	std::printf("%d climbers, %d iterations, ns per climber\n", NumClimbers, iterations);
+	std::printf("  CheckStartClimbingSurface   %8.2f\n", scalarStartCheck);
+	std::printf("  CheckStartClimbingSurfaces  %8.2f\n", batchedStartCheck);
+	std::printf("  ComputeSnapDelta            %8.2f\n", scalarSnap);
+	std::printf("  ComputeSnapDeltas           %8.2f\n", batchedSnap);
+	std::printf("  ComputeSurfaceInfo (mock)   %8.2f\n", surfaceInfo);
+	std::printf("  CanStartClimbing (mock)     %8.2f\n", canStartClimbing);
+
+	return 0;
+}
@@ -0,0 +1,296 @@
+#include "ClimbingMath.h"
+#include "MockCollision.h"
+
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace ClimbingMath;
+
+namespace
+{
+	int NumFailures = 0;
+
+	void Check(bool condition, const char* expression, const char* file, int line)
+	{
+		if (condition == false)
+		{
+			std::printf("%s:%d: CHECK(%s) failed\n", file, line, expression);
+			++NumFailures;
+		}
+	}
+
+	bool IsNear(double a, double b, double tolerance = 1.e-6)
+	{
+		return std::abs(a - b) <= tolerance;
+	}
+
+	bool IsNear(const FVec3& a, const FVec3& b, double tolerance = 1.e-6)
+	{
+		return IsNear(a.X, b.X, tolerance) && IsNear(a.Y, b.Y, tolerance) && IsNear(a.Z, b.Z, tolerance);
+	}
+
+	/** A 200 high wall facing -X at X = 100, on a floor at Z = 0. */
+	FMockCollision MakeWallWorld()
+	{
+		FMockCollision world;
+		world.AddBox(FVec3(-1000., -1000., -10.), FVec3(1000., 1000., 0.));
+		world.AddBox(FVec3(100., -500., 0.), FVec3(200., 500., 200.));
+		return world;
+	}
+
+	FHit MakeWallHit(const FVec3& location, const FVec3& normal, bool isWalkable = false)
+	{
+		FHit hit;
+		hit.Location = location;
+		hit.Normal = normal;
+		hit.bWalkable = isWalkable;
+		return hit;
+	}
+
+	FVec3 MakeHorizontalNormal(double degrees)
+	{
+		const double radians = degrees * (3.14159265358979323846 / 180.);
+		return FVec3(-std::cos(radians), std::sin(radians), 0.);
+	}
+}
+
+#define CHECK(condition) Check((condition), #condition, __FILE__, __LINE__)
+
+static void TestCheckStartClimbingSurface()
+{
+	const FVec3 forward(1., 0., 0.);
+
+	const FStartClimbingCheck wall = CheckStartClimbingSurface(forward, FVec3(-1., 0., 0.), 25.);
+	CHECK(wall.bCanStart);
+	CHECK(IsNear(wall.Steepness, 1.));
+
+	CHECK(CheckStartClimbingSurface(forward, MakeHorizontalNormal(20.), 25.).bCanStart);
+	CHECK(CheckStartClimbingSurface(forward, MakeHorizontalNormal(30.), 25.).bCanStart == false);
+	CHECK(CheckStartClimbingSurface(forward, FVec3(1., 0., 0.), 25.).bCanStart == false);
+	CHECK(CheckStartClimbingSurface(forward, FVec3(0., 0., -1.), 25.).bCanStart == false);
+
+	const FStartClimbingCheck slope = CheckStartClimbingSurface(forward, FVec3(-0.6, 0., 0.8), 25.);
+	CHECK(slope.bCanStart);
+	CHECK(IsNear(slope.Steepness, 0.6));
+}
+
+static void TestCheckStartClimbingSurfacesBatch()
+{
+	constexpr int count = 4096;
+	constexpr double maxHorizontalDegrees = 25.;
+
+	std::mt19937 random(42);
+	std::uniform_real_distribution<double> component(-1., 1.);
+
+	std::vector<double> forwardX(count), forwardY(count), forwardZ(count), normalX(count), normalY(count), normalZ(count);
+	for (int index = 0; index < count; ++index)
+	{
+		const FVec3 forward = GetSafeNormal2D(FVec3(component(random), component(random), 0.));
+		const FVec3 normal = GetSafeNormal(FVec3(component(random), component(random), component(random)));
+
+		forwardX[index] = forward.X;
+		forwardY[index] = forward.Y;
+		forwardZ[index] = forward.Z;
+		normalX[index] = normal.X;
+		normalY[index] = normal.Y;
+		normalZ[index] = normal.Z;
+	}
+
+	// A ceiling, with no horizontal normal at all.
+	normalX[0] = 0.;
+	normalY[0] = 0.;
+	normalZ[0] = -1.;
+
+	const std::unique_ptr<bool[]> canStart = std::make_unique<bool[]>(count);
+	std::vector<double> steepness(count);
+	CheckStartClimbingSurfaces(count, { forwardX.data(), forwardY.data(), forwardZ.data() }, { normalX.data(), normalY.data(), normalZ.data() },
+		maxHorizontalDegrees, canStart.get(), steepness.data());
+
+	int numMismatches = 0;
+	int numCanStart = 0;
+
+	for (int index = 0; index < count; ++index)
+	{
+		const FStartClimbingCheck check = CheckStartClimbingSurface(FVec3(forwardX[index], forwardY[index], forwardZ[index]),
+			FVec3(normalX[index], normalY[index], normalZ[index]), maxHorizontalDegrees);
+
+		numMismatches += (check.bCanStart != canStart[index] || IsNear(check.Steepness, steepness[index], 1.e-9) == false) ? 1 : 0;
+		numCanStart += check.bCanStart ? 1 : 0;
+	}
+
+	CHECK(numMismatches == 0);
+	CHECK(numCanStart > 0);
+	CHECK(canStart[0] == false);
+}
+
+static void TestComputeSurfaceInfo()
+{
+	const FMockCollision world = MakeWallWorld();
+	const FVec3 start(0., 0., 100.);
+	const FVec3 wallPoints[] = { { 100., -20., 80. }, { 100., 20., 80. }, { 100., -20., 120. }, { 100., 20., 120. } };
+
+	const FSurfaceInfo surface = ComputeSurfaceInfo(world, start, wallPoints, 4, 6., 120.);
+	CHECK(IsNear(surface.Normal, FVec3(-1., 0., 0.)));
+	CHECK(IsNear(surface.Position, FVec3(94., 0., 100.)));
+	CHECK(world.NumQueries == 4);
+
+	// Out of reach, misses only contribute zero samples.
+	const FVec3 farPoints[] = { { 400., 0., 100. } };
+	const FSurfaceInfo farSurface = ComputeSurfaceInfo(MakeWallWorld(), FVec3(-300., 0., 100.), farPoints, 1, 6., 120.);
+	CHECK(IsZero(farSurface.Normal));
+	CHECK(IsZero(farSurface.Position));
+
+	const FSurfaceInfo noSurface = ComputeSurfaceInfo(world, start, wallPoints, 0);
+	CHECK(IsZero(noSurface.Normal));
+}
+
+static void TestCanStartClimbing()
+{
+	const FMockCollision world = MakeWallWorld();
+	const FVec3 forward(1., 0., 0.);
+	const FHit wallHit = MakeWallHit(FVec3(100., 0., 100.), FVec3(-1., 0., 0.));
+
+	CHECK(CanStartClimbing(world, FVec3(40., 0., 150.), forward, &wallHit, 1, 25.));
+
+	// Too far for the facing trace of a vertical wall.
+	CHECK(CanStartClimbing(world, FVec3(0., 0., 150.), forward, &wallHit, 1, 25.) == false);
+
+	// Facing along the wall.
+	CHECK(CanStartClimbing(world, FVec3(40., 0., 150.), FVec3(0., 1., 0.), &wallHit, 1, 25.) == false);
+
+	const FHit floorHit = MakeWallHit(FVec3(40., 0., 0.), FVec3(-0.6, 0., 0.8), true);
+	CHECK(CanStartClimbing(world, FVec3(40., 0., 150.), forward, &floorHit, 1, 25.) == false);
+
+	CHECK(CanStartClimbing(world, FVec3(40., 0., 150.), forward, nullptr, 0, 25.) == false);
+}
+
+static void TestHasReachedEdge()
+{
+	const FMockCollision world = MakeWallWorld();
+	const FVec3 forward(1., 0., 0.);
+
+	CHECK(HasReachedEdge(world, FVec3(40., 0., 250.), forward, 100.));
+	CHECK(HasReachedEdge(world, FVec3(40., 0., 150.), forward, 100.) == false);
+}
+
+static void TestComputeLedgeClimbTarget()
+{
+	// Facing a wall: moved forward by the capsule's width and the distance kept from the wall, up by the capsule and eye heights.
+	const FLedgeClimbTarget wallTarget = ComputeLedgeClimbTarget(FVec3(55., 0., 100.), FVec3(1., 0., 0.), 1., 30., 66., 114., 45.);
+	CHECK(IsNear(wallTarget.HorizontalOffset, FVec3(105., 0., 0.)));
+	CHECK(IsNear(wallTarget.Position, FVec3(160., 0., 280.)));
+
+	// Facing down a slope, the steepness correction adds the capsule and eye heights.
+	const FVec3 slopeForward = GetSafeNormal(FVec3(0.8, 0., -0.6));
+	const FLedgeClimbTarget slopeTarget = ComputeLedgeClimbTarget(FVec3(), slopeForward, 0.8, 30., 66., 114., 45.);
+	const double distanceToLedge = 0.4 * 105. + 0.6 * 180.;
+	CHECK(IsNear(slopeTarget.HorizontalOffset, FVec3(0.8 * distanceToLedge, 0., 0.)));
+	CHECK(IsNear(slopeTarget.Position.Z, 66. + 114. * 0.8));
+}
+
+static void TestCanMoveToLedgeClimbTarget()
+{
+	FMockCollision world = MakeWallWorld();
+	const FLedgeClimbTarget target = ComputeLedgeClimbTarget(FVec3(55., 0., 100.), FVec3(1., 0., 0.), 1., 30., 66., 114., 45.);
+
+	CHECK(CanMoveToLedgeClimbTarget(world, target, 30., 66., 66.));
+
+	// The ground is looked for as far below the target as the walkable trace half height says, not the swept capsule's.
+	CHECK(CanMoveToLedgeClimbTarget(world, target, 30., 66., 40.) == false);
+
+	// Nothing to stand on past the wall.
+	FLedgeClimbTarget pastWall = target;
+	pastWall.Position.X = 260.;
+	CHECK(CanMoveToLedgeClimbTarget(world, pastWall, 30., 66., 66.) == false);
+
+	// Something on top of the ledge is in the way.
+	world.AddBox(FVec3(130., -50., 200.), FVec3(140., 50., 400.));
+	CHECK(CanMoveToLedgeClimbTarget(world, target, 30., 66., 66.) == false);
+}
+
+static void TestComputeSnapDelta()
+{
+	FSurfaceInfo surface;
+	surface.Position = FVec3(100., 0., 0.);
+	surface.Normal = FVec3(-1., 0., 0.);
+
+	// 55 too far from the surface, covered at the snap speed.
+	const FVec3 delta = ComputeSnapDelta(FVec3(), FVec3(1., 0., 0.), surface, 45., 4., 0.5);
+	CHECK(IsNear(delta, FVec3(110., 0., 0.)));
+
+	const FVec3 tooClose = ComputeSnapDelta(FVec3(80., 0., 0.), FVec3(1., 0., 0.), surface, 45., 1., 1.);
+	CHECK(IsNear(tooClose, FVec3(-25., 0., 0.)));
+}
+
+static void TestComputeSnapDeltasBatch()
+{
+	constexpr int count = 1024;
+
+	std::mt19937 random(7);
+	std::uniform_real_distribution<double> coordinate(-500., 500.);
+	std::uniform_real_distribution<double> component(-1., 1.);
+
+	std::vector<double> values(count * 12);
+	for (double& value : values)
+	{
+		value = coordinate(random);
+	}
+
+	const auto column = [&values](int index) { return values.data() + index * count; };
+
+	// Forwards and normals are unit vectors in the movement component.
+	for (int index = 0; index < count; ++index)
+	{
+		for (int vector : { 3, 9 })
+		{
+			const FVec3 unit = GetSafeNormal(FVec3(component(random), component(random), component(random)));
+			column(vector)[index] = unit.X;
+			column(vector + 1)[index] = unit.Y;
+			column(vector + 2)[index] = unit.Z;
+		}
+	}
+
+	std::vector<double> deltaX(count), deltaY(count), deltaZ(count);
+	ComputeSnapDeltas(count, { column(0), column(1), column(2) }, { column(3), column(4), column(5) }, { column(6), column(7), column(8) },
+		{ column(9), column(10), column(11) }, 45., 4., 1. / 60., { deltaX.data(), deltaY.data(), deltaZ.data() });
+
+	int numMismatches = 0;
+	for (int index = 0; index < count; ++index)
+	{
+		FSurfaceInfo surface;
+		surface.Position = FVec3(column(6)[index], column(7)[index], column(8)[index]);
+		surface.Normal = FVec3(column(9)[index], column(10)[index], column(11)[index]);
+
+		const FVec3 delta = ComputeSnapDelta(FVec3(column(0)[index], column(1)[index], column(2)[index]),
+			FVec3(column(3)[index], column(4)[index], column(5)[index]), surface, 45., 4., 1. / 60.);
+
+		numMismatches += IsNear(delta, FVec3(deltaX[index], deltaY[index], deltaZ[index]), 1.e-9) ? 0 : 1;
+	}
+
+	CHECK(numMismatches == 0);
+}
+
+int main()
+{
+	TestCheckStartClimbingSurface();
+	TestCheckStartClimbingSurfacesBatch();
+	TestComputeSurfaceInfo();
+	TestCanStartClimbing();
+	TestHasReachedEdge();
+	TestComputeLedgeClimbTarget();
+	TestCanMoveToLedgeClimbTarget();
+	TestComputeSnapDelta();
+	TestComputeSnapDeltasBatch();
+
+	if (NumFailures > 0)
+	{
+		std::printf("%d checks failed\n", NumFailures);
+		return 1;
+	}
+
+	std::printf("All ClimbingMath tests passed\n");
+	return 0;
+}
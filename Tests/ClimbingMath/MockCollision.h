@@ -0,0 +1,131 @@
+#pragma once
+
+#include "ClimbingMath.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+/**
+ * Collision world made of axis aligned boxes, standing in for UWorld in the ClimbingMath tests and benchmark.
+ * Shapes are swept as their axis aligned bounds, exact for lines and close enough for spheres and upright capsules.
+ */
+class FMockCollision final : public ClimbingMath::ICollisionQuery
+{
+public:
+	struct FBox
+	{
+		ClimbingMath::FVec3 Min;
+		ClimbingMath::FVec3 Max;
+	};
+
+	/** Same default as the character movement component's walkable floor angle of 44.765 degrees. */
+	double WalkableFloorZ = 0.71;
+
+	mutable int NumQueries = 0;
+
+	void AddBox(const ClimbingMath::FVec3& min, const ClimbingMath::FVec3& max)
+	{
+		Boxes.push_back({ min, max });
+	}
+
+	virtual bool LineTrace(const ClimbingMath::FVec3& start, const ClimbingMath::FVec3& end, ClimbingMath::FHit& outHit) const override
+	{
+		return Sweep(start, end, ClimbingMath::FVec3(), outHit);
+	}
+
+	virtual bool SweepSphere(const ClimbingMath::FVec3& start, const ClimbingMath::FVec3& end, double radius, ClimbingMath::FHit& outHit) const override
+	{
+		return Sweep(start, end, ClimbingMath::FVec3(radius, radius, radius), outHit);
+	}
+
+	virtual bool SweepCapsule(const ClimbingMath::FVec3& start, const ClimbingMath::FVec3& end, double radius, double halfHeight,
+		ClimbingMath::FHit& outHit) const override
+	{
+		return Sweep(start, end, ClimbingMath::FVec3(radius, radius, halfHeight), outHit);
+	}
+
+private:
+	std::vector<FBox> Boxes;
+
+	bool Sweep(const ClimbingMath::FVec3& start, const ClimbingMath::FVec3& end, const ClimbingMath::FVec3& extent, ClimbingMath::FHit& outHit) const
+	{
+		++NumQueries;
+
+		const ClimbingMath::FVec3 delta = end - start;
+		const double starts[] = { start.X, start.Y, start.Z };
+		const double deltas[] = { delta.X, delta.Y, delta.Z };
+		const double extents[] = { extent.X, extent.Y, extent.Z };
+
+		double closestTime = std::numeric_limits<double>::max();
+		ClimbingMath::FVec3 closestNormal;
+
+		for (const FBox& box : Boxes)
+		{
+			// Slab test against the box grown by the shape's extent.
+			const double mins[] = { box.Min.X - extents[0], box.Min.Y - extents[1], box.Min.Z - extents[2] };
+			const double maxs[] = { box.Max.X + extents[0], box.Max.Y + extents[1], box.Max.Z + extents[2] };
+
+			double entryTime = 0.;
+			double exitTime = 1.;
+			int entryAxis = -1;
+			double entrySign = 0.;
+			bool isMissed = false;
+
+			for (int axis = 0; axis < 3 && isMissed == false; ++axis)
+			{
+				if (std::abs(deltas[axis]) < ClimbingMath::SmallNumber)
+				{
+					isMissed = starts[axis] < mins[axis] || starts[axis] > maxs[axis];
+					continue;
+				}
+
+				double nearTime = (mins[axis] - starts[axis]) / deltas[axis];
+				double farTime = (maxs[axis] - starts[axis]) / deltas[axis];
+				double sign = -1.;
+
+				if (nearTime > farTime)
+				{
+					std::swap(nearTime, farTime);
+					sign = 1.;
+				}
+
+				if (nearTime > entryTime)
+				{
+					entryTime = nearTime;
+					entryAxis = axis;
+					entrySign = sign;
+				}
+
+				exitTime = std::min(exitTime, farTime);
+				isMissed = entryTime > exitTime;
+			}
+
+			if (isMissed || entryTime >= closestTime)
+			{
+				continue;
+			}
+
+			closestTime = entryTime;
+
+			// Starting inside the box, the engine reports a penetrating hit facing back along the sweep.
+			closestNormal = entryAxis < 0 ? ClimbingMath::GetSafeNormal(-delta) : ClimbingMath::FVec3(
+				entryAxis == 0 ? entrySign : 0.,
+				entryAxis == 1 ? entrySign : 0.,
+				entryAxis == 2 ? entrySign : 0.);
+		}
+
+		if (closestTime > 1.)
+		{
+			return false;
+		}
+
+		// Where the shape's center was when it touched, which is the impact point for line traces.
+		outHit.Location = start + delta * closestTime;
+		outHit.Normal = closestNormal;
+		outHit.bWalkable = closestNormal.Z >= WalkableFloorZ;
+
+		return true;
+	}
+};
@@ -0,0 +1,33 @@
+#!/usr/bin/env bash
+# Measures per-connection bandwidth and server CPU with headless climbing bots, with climb.AdaptiveReplication off then on.
+# Each run writes a CSV to Saved/Profiling/ClimbingNetStats and logs its averages, see AClimbingSystemGameMode.
+#
+# Usage: UE_EDITOR=/path/to/UnrealEditor Tests/ClimbingNet/MeasureClimbingNet.sh [NumBots=16] [DurationSeconds=120]
+set -euo pipefail
+
+editor="${UE_EDITOR:?Set UE_EDITOR to the UnrealEditor binary}"
+project="$(cd "$(dirname "$0")/../.." && pwd)/ClimbingSystem.uproject"
+map=/Game/ClimbingSystem/Maps/TestClimbingLevel
+numBots="${1:-16}"
+duration="${2:-120}"
+
+for adaptiveReplication in 0 1; do
+	"$editor" "$project" "$map" -server -nullrhi -unattended -log -ClimbingNetStats -ClimbingNetStatsDuration="$duration" \
+		-ExecCmds="climb.AdaptiveReplication $adaptiveReplication" &
+	server=$!
+
+	# Let the server load the map before the bots connect.
+	sleep 20
+
+	bots=()
+	for ((bot = 0; bot < numBots; ++bot)); do
+		"$editor" "$project" 127.0.0.1 -game -nullrhi -nosound -unattended -ClimbingBot > /dev/null 2>&1 &
+		bots+=($!)
+	done
+
+	wait "$server"
+	kill "${bots[@]}" 2> /dev/null || true
+	wait || true
+done
+
+ls -t "$(dirname "$project")/Saved/Profiling/ClimbingNetStats"/*.csv | head -n 2